@@ -0,0 +1,31 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+#include "UnitPool.h"
+
+// Hashed timing wheel of unit arrivals. A unit is filed under its arrival
+// tick modulo the number of buckets, which grows to stay above the
+// longest trip scheduled, so the bucket for a tick holds only the units
+// landing on it and collecting them does not look at any other unit.
+class ArrivalWheel {
+public:
+    // now is the current tick; arrival must not be before it.
+    void schedule(UnitHandle unit, int arrival, int now);
+
+    // Appends the units arriving on tick to out and forgets them.
+    void take(int tick, std::vector<UnitHandle>& out);
+
+    void clear();
+    size_t size() const { return count; }
+
+private:
+    struct Entry {
+        UnitHandle unit;
+        int arrival;
+    };
+
+    void grow(size_t span);
+
+    std::vector<std::vector<Entry>> buckets; // size is a power of two
+    size_t count = 0;
+};
@@ -0,0 +1,32 @@
+#pragma once
+
+// Maps world coordinates (node positions) to canvas coordinates. zoom is
+// canvas units per world unit; (centerX, centerY) is the world point shown
+// in the middle of the canvas.
+class Camera {
+public:
+    float centerX = 0.0f, centerY = 0.0f;
+    float zoom = 1.0f;
+    float viewW = 0.0f, viewH = 0.0f; // canvas size
+
+    static constexpr float MIN_ZOOM = 0.02f;
+    static constexpr float MAX_ZOOM = 4.0f;
+
+    void setView(float w, float h);
+
+    // Identity for maps that fit the canvas, otherwise zoomed out to show
+    // the whole of [minX, maxX] x [minY, maxY].
+    void fit(float minX, float minY, float maxX, float maxY);
+
+    float toCanvasX(float wx) const { return (wx - centerX) * zoom + viewW * 0.5f; }
+    float toCanvasY(float wy) const { return (wy - centerY) * zoom + viewH * 0.5f; }
+    float toWorldX(float cx) const { return (cx - viewW * 0.5f) / zoom + centerX; }
+    float toWorldY(float cy) const { return (cy - viewH * 0.5f) / zoom + centerY; }
+
+    void pan(float canvasDx, float canvasDy);
+
+    // Scales by factor keeping the world point under (canvasX, canvasY) fixed.
+    void zoomAt(float factor, float canvasX, float canvasY);
+
+    void visibleRect(float& minX, float& minY, float& maxX, float& maxY) const;
+};
@@ -0,0 +1,84 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "GlobalState.h"
+#include "Spectator.h"
+
+// Lockstep client for LockstepServer. It drives a GlobalState from the
+// server's batches instead of from a local clock: one batch, one step.
+//
+// Local input keeps going through game.submit(); poll() takes those
+// commands out of the state before they are applied and sends them to the
+// server, scheduled inputDelay ticks ahead. They come back in a batch
+// once the server has accepted them.
+class LockstepClient {
+public:
+    explicit LockstepClient(GlobalState& game);
+    ~LockstepClient();
+
+    LockstepClient(const LockstepClient&) = delete;
+    LockstepClient& operator=(const LockstepClient&) = delete;
+
+    // side: 0 blue, 1 red, 2 whichever is free.
+    bool connect(const std::string& host, uint16_t port, uint32_t matchId, int side,
+                 std::string& error);
+    void close();
+
+    // Sends queued local commands, then applies every batch that has
+    // arrived. false (with error) when disconnected or out of sync.
+    bool poll(std::string& error);
+
+    bool joined() const { return welcomed; }
+    Owner side() const { return mySide; }
+    int fd() const { return sock; }
+
+    int batches = 0;       // steps taken from the server
+    int hashChecks = 0;    // of which with a state hash to compare
+    int desyncs = 0;       // hashes that did not match ours; poll() fails on one
+
+private:
+    bool onFrame(uint8_t type, const uint8_t* p, size_t size, std::string& error);
+    void sendPending();
+
+    GlobalState& game;
+    int sock = -1;
+    bool welcomed = false;
+    Owner mySide = Owner::Player;
+    int inputDelay = 0;
+
+    std::vector<uint8_t> in, out;
+    std::vector<uint8_t> snapshot; // aligned copy of the Welcome state
+};
+
+// Watches a LockstepServer match: the server's keyframes and deltas go
+// into a GlobalState that is drawn but never stepped.
+class SpectatorClient {
+public:
+    explicit SpectatorClient(GlobalState& view);
+    ~SpectatorClient();
+
+    SpectatorClient(const SpectatorClient&) = delete;
+    SpectatorClient& operator=(const SpectatorClient&) = delete;
+
+    bool connect(const std::string& host, uint16_t port, uint32_t matchId, std::string& error);
+    void close();
+
+    // Applies every message that has arrived. false (with error) when
+    // disconnected; a bad delta is counted and skipped until the next
+    // keyframe.
+    bool poll(std::string& error);
+
+    bool ready() const { return decoder.ready(); }
+    int fd() const { return sock; }
+    const SpectatorDecoder& stream() const { return decoder; }
+
+    long long bytes = 0;    // received, framing included
+    int errors = 0;         // messages the decoder rejected
+
+private:
+    GlobalState& view;
+    SpectatorDecoder decoder;
+    int sock = -1;
+    std::vector<uint8_t> in, out;
+};
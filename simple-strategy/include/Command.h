@@ -0,0 +1,14 @@
+#pragma once
+
+// Everything that can change the simulation from outside goes through a
+// Command, so a frontend, a bot or a recorded stream all drive it the same way.
+enum class CommandType {
+    Start,
+    Connect
+};
+
+struct Command {
+    CommandType type = CommandType::Start;
+    int from = -1; // node ids, Connect only
+    int to = -1;
+};
@@ -0,0 +1,48 @@
+#pragma once
+#include <chrono>
+#include "GlobalState.h"
+#include "Node.h"
+
+struct AIConfig {
+    int budgetUs = 300;          // planning time per update(); <= 0 plans a full pass every call
+    float actionInterval = 1.5f; // seconds of match time between roads
+    float reach = 260.0f;        // only connect to nodes this close, canvas units
+    int minUnits = 3;            // sources with fewer units are not worth a road
+};
+
+// How much side wants a road from -> to; <= 0 means not worth building.
+// Shared by the bots so they agree on what a good road is.
+float scoreRoad(const GlobalState& game, const Node& from, const Node& to, Owner side);
+
+// Computer opponent for one side. It builds roads through the same
+// Connect commands and canCreateEdge rules as the player.
+//
+// Planning is anytime: each update() scans supplied nodes of its side from
+// where the last call stopped, scoring the roads each could build, until
+// the time budget runs out. When a pass over all nodes completes, the best
+// road found is submitted (once actionInterval has passed) and a new pass
+// starts. A large map just takes more calls per pass, never a longer call.
+class EnemyAI {
+public:
+    explicit EnemyAI(Owner side = Owner::Enemy, const AIConfig& config = AIConfig());
+
+    AIConfig config;
+
+    // Plans for at most config.budgetUs and may submit one Connect.
+    void update(GlobalState& game);
+
+    // Forgets the current plan, e.g. after loading a different match.
+    void reset();
+
+    Owner side() const { return me; }
+
+private:
+    void scanSource(const GlobalState& game, const Node& from);
+
+    Owner me;
+    size_t cursor = 0;   // next node to scan in the current pass
+    bool planned = false; // pass finished, waiting to act on best
+    int bestFrom = -1, bestTo = -1;
+    float bestScore = 0.0f;
+    int lastActionTick = -1000000;
+};
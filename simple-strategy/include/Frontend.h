@@ -0,0 +1,105 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "Camera.h"
+#include "Client.h"
+#include "EnemyAI.h"
+#include "GlobalState.h"
+#include "Profiler.h"
+#include "RoadBatch.h"
+#include "UnitBatch.h"
+#include "ViewIndex.h"
+
+// Windowed SGG frontend: turns mouse/keyboard input into Commands for the
+// simulation and draws its state. All graphics calls live on this side.
+class Frontend {
+public:
+    Frontend(GlobalState& game, float canvasW, float canvasH);
+
+    void update(float dt_ms);
+    void draw(float alpha);
+
+    // Frames the loaded map; call after loading.
+    void resetCamera();
+
+    // Frees GL resources; call before destroying the window.
+    void shutdown();
+
+    // With the AI on (the default) it plays the red side and only blue
+    // nodes can be selected; off, one person plays both.
+    void setAIEnabled(bool on) { aiEnabled = on; }
+
+    // Plays a server match through client instead of stepping the game
+    // locally; the AI is off and only the client's side can be selected.
+    void setClient(LockstepClient* c) { client = c; }
+
+    // Shows a server match from its spectator stream; no input but the
+    // camera and the profiler.
+    void setWatcher(SpectatorClient* w) { watcher = w; }
+
+private:
+    void handleInput();
+    void handleCamera(float dt_ms);
+    void handleQuickSave();
+    void handleProfiler();
+
+    void syncView(); // road caches, the view index and visibleRoads
+    void drawRoads();
+    void drawNode(const Node& n);
+    void drawUnits(float alpha);
+    void drawUnit(float x, float y, Owner owner);
+    void drawHud();
+    void drawProfile();
+
+    const std::string& countLabel(int count);
+
+    GlobalState& game;
+
+    Camera camera;
+
+    Node* selectedNode = nullptr;
+    std::string statusText = "Click a NODE to select.";
+
+    // road endpoints as x1, y1, x2, y2 per road, rebuilt only when the
+    // simulation's roadVersion moves; the batch holds the same on the GPU
+    std::vector<float> roadVertices;
+    int roadVersion = -1;
+    RoadBatch roadBatch;
+    bool roadBatchTried = false;
+
+    // roads and units near the view, so drawing does not walk the world
+    ViewIndex viewIndex;
+    std::vector<int> visibleRoads;
+
+    // "0", "1", ... built once up to the largest count seen, so node labels
+    // never format or allocate a string per frame
+    std::vector<std::string> countLabels;
+
+    // per screen cell and owner unit counts, used when zoomed out too far
+    // to draw units one by one
+    std::vector<int> density;
+    std::vector<int> visibleNodes;
+
+    // instanced path for individual units; drawDisk per unit if the GL
+    // context cannot do it
+    UnitBatch unitBatch;
+    bool unitBatchTried = false;
+
+    EnemyAI enemyAI;
+    bool aiEnabled = true;
+
+    LockstepClient* client = nullptr;
+    SpectatorClient* watcher = nullptr;
+    bool disconnected = false;
+
+    // times this frontend's passes and, through game.profiler, the
+    // simulation's; F3 shows it, F4 writes the recent trace
+    Profiler profiler;
+    bool showProfile = false;
+
+    // keys held last frame, so a held key acts once
+    bool saveKeyDown = false;
+    bool loadKeyDown = false;
+    bool profileKeyDown = false;
+    bool traceKeyDown = false;
+};
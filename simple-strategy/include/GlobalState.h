@@ -1,39 +1,169 @@
 #pragma once
-#include <vector>
+#include <string>
 #include <unordered_map>
+#include <vector>
+#include <cstdint>
+#include "ArrivalWheel.h"
+#include "Command.h"
+#include "Map.h"
+#include "Rules.h"
+#include "Snapshot.h"
+#include "SpatialGrid.h"
+#include "TickClock.h"
 #include "Node.h"
+#include "Profiler.h"
 #include "Unit.h"
+#include "UnitPool.h"
+
+class ReplayLog;
+
+// A two-way road between two nodes, stored once.
+struct Road {
+    int a, b; // node ids
+};
+
+// A unit sent during the current tick.
+struct SentUnit {
+    int from, to; // node ids
+    Owner owner;
+    UnitHandle unit; // its entry in units
+    bool joined;     // the entry is a run that already existed
+};
 
+// The simulation core. It has no graphics or window dependency: a frontend
+// (or a bot, or a test harness) feeds it Commands and calls update() with
+// real frame time, or step() directly to run fixed ticks as fast as it can.
 class GlobalState {
 public:
-    ~GlobalState();
+    // One block for all nodes, sized at load time and never grown
+    // afterwards, so Node* and Node& stay valid for the whole match.
+    std::vector<Node> nodes;
+    std::vector<Road> roads; // every road once, in creation order
+    int roadVersion = 0;     // bumped whenever roads changes
 
-    std::vector<Node*> nodes;
-    std::vector<Unit*> units;
+    SpatialGrid grid; // node positions, for picking and view queries
+    UnitPool units;
+    ArrivalWheel arrivalWheel;      // every unit in units, by arrival tick
+    std::vector<uint32_t> arrivals; // this tick's, ascending positions in units
+    std::vector<SentUnit> sent;     // this tick's, in send order
 
-    Node* selectedNode = nullptr;
+    Rules rules;
 
-    Node* playerBase = nullptr;
-    Node* enemyBase  = nullptr;
+    // run step() with the compiled ruleset when rules equal one (see
+    // Ruleset.h); false reads every value from rules, for comparison
+    bool specialize = true;
+
+    int playerBase = -1; // node ids
+    int enemyBase  = -1;
 
     bool gameOver = false;
     Owner winner = Owner::Player;
 
-    std::unordered_map<Node*, float> sendTimers;
+    // Per-node tick state, indexed by node id so the production and
+    // sending passes are linear sweeps over packed arrays.
+    std::vector<float> sendTimer;
+    std::vector<float> productionTimer;
+    std::vector<int> roundRobin;
+    std::vector<uint8_t> sendPhase; // 0: forward, 1: same level
+
+    // 1 if the node is connected to its owner's base through same-owner
+    // roads; recomputed only when a road is added or a node flips
+    std::vector<uint8_t> supplied;
+    std::vector<int> supplyQueue; // scratch for rebuildSupply
+
+    // commands queued since the last step, applied at its start
+    std::vector<Command> pending;
+
+    TickClock clock;
+    int tick = 0; // simulated steps since the game started
+
+    // if set, gets every command that took effect, with its tick; not
+    // owned, and copied along with the state, so clear it on copies that
+    // must not record
+    ReplayLog* recorder = nullptr;
+
+    // if set, update() and the phases of step() are timed into it; not
+    // owned, and like the recorder not carried over by cloneFrom
+    Profiler* profiler = nullptr;
 
     void init();
+    void load(const MapView& map);
+    bool loadFile(const std::string& path, std::string& error);
+
+    // Makes this an independent copy of other, for search and rollouts.
+    // Reuses this state's storage (node edge lists included), so cloning
+    // into a scratch state that already held a copy of the same match does
+    // not allocate. The recorder and profiler are not copied.
+    void cloneFrom(const GlobalState& other);
+
+    // Full state to and from the snapshot format. restore() reuses the
+    // existing arrays, so restoring a state of the same shape as the
+    // current one does not allocate. The recorder is left alone.
+    void snapshot(std::vector<uint8_t>& out) const;
+    void restore(const SnapshotView& snap);
+    bool restoreFile(const std::string& path, std::string& error);
+
     void update(float dt_ms);
-    void draw();
+    void step();
+
+    // Sends a unit along a road during the current tick and files it
+    // under the tick it lands on. With unit streams it joins the road's
+    // last run when it keeps that run's spacing; the handle is the run's.
+    UnitHandle spawnUnit(int fromId, int toId, Owner owner);
+
+    // Fills arrivals with the entries of units whose head lands on the
+    // current tick, ascending, so they resolve in pool order.
+    void collectArrivals();
+
+    // After arrivals are resolved: a run moves on to its next unit, and
+    // single units and finished runs leave the pool.
+    void retireArrivals();
+
+    // Units on the roads; units.size() counts runs.
+    size_t unitsInFlight() const;
+
+    void submit(const Command& cmd);
+    bool applyCommand(const Command& cmd); // false if it changed nothing
 
-    void handleInput();
-    Node* pickNode(float x, float y) const;
+    // Digest of everything that evolves during a match, for comparing runs.
+    uint64_t stateHash() const;
+
+    Node* nodeById(int id);
+    Node* pickNode(float x, float y);
 
     Node* chooseTarget(Node* source);
+    void rebuildAdjacency(Node& n);
 
-    Node* getBase(Owner owner) const;
+    const Node* getBase(Owner owner) const;
     bool gameStarted = false;
-    bool hasChainToBase(Node* n, Owner owner) const;
-    bool canCreateEdge(Node* from, Node* to, Owner owner) const;
-    bool edgeExistsUndirected(Node* a, Node* b) const;
+    bool canSelect(const Node* n) const;
+    bool hasChainToBase(const Node* n, Owner owner) const;
+    void rebuildSupply(Owner owner);
+    void spreadSupply(int id, Owner owner);
+    bool canCreateEdge(const Node* from, const Node* to, Owner owner) const;
+    bool edgeExistsUndirected(const Node* a, const Node* b) const;
     void createSharedConnection(Node* a, Node* b);
+
+private:
+    // travelTicks() of the last speed asked for; every unit has the same
+    int travelFor(float speed);
+    float travelSpeed = -1.0f;
+    int travelSteps = 0;
+
+    std::vector<UnitHandle> landing;  // scratch for collectArrivals
+    std::vector<uint32_t> exhausted;  // scratch for retireArrivals
+
+    // with unit streams, the newest run on each road by (from << 32 | to);
+    // stale handles just mean the road has none
+    std::unordered_map<uint64_t, UnitHandle> streamTails;
+    void rebuildStreamTails();
+
+    template <class R> Node* chooseTarget(const R& r, Node* source);
+    template <class R> UnitHandle spawnUnit(const R& r, int fromId, int toId, Owner owner);
+
+    // the phases of step(), for a ruleset R from Ruleset.h or Rules
+    template <class R> void runPhases(const R& r);
+    template <class R> void produce(const R& r, float dt);
+    template <class R> void send(const R& r, float dt);
+    void resolveArrivals();
 };
@@ -0,0 +1,103 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Map description shared by the built-in layout, the text format and the
+// binary format. Records are plain 4-byte fields so a binary map can be
+// used in place straight from a memory-mapped file.
+//
+// Text format, one record per line, '#' starts a comment:
+//     node <x> <y> <layer> <player|enemy> [capacity] [units]
+//     edge <a> <b>
+//     base <player|enemy> <node>
+// Nodes are numbered in the order they appear. A side without a base line
+// uses its first layer-0 node.
+//
+// Binary format: MapHeader, then nodeCount MapNode records, then
+// edgeCount MapEdge records, native byte order.
+
+static constexpr char MAP_MAGIC[4] = { 'S', 'S', 'M', 'P' };
+static constexpr uint32_t MAP_VERSION = 1;
+
+// World extent: node coordinates must be finite and within
+// [-MAP_EXTENT, MAP_EXTENT] on both axes.
+static constexpr float MAP_EXTENT = 1.0e7f;
+
+struct MapHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t nodeCount;
+    uint32_t edgeCount;
+    int32_t playerBase;
+    int32_t enemyBase;
+};
+
+struct MapNode {
+    float x, y;
+    int32_t layer;
+    int32_t owner;    // Owner value
+    int32_t capacity;
+    int32_t unitCount;
+};
+
+struct MapEdge {
+    int32_t a, b;
+};
+
+// Non-owning view of a map, either into a MapData or a MapFile.
+struct MapView {
+    const MapNode* nodes = nullptr;
+    uint32_t nodeCount = 0;
+    const MapEdge* edges = nullptr;
+    uint32_t edgeCount = 0;
+    int playerBase = -1;
+    int enemyBase = -1;
+};
+
+struct MapData {
+    std::vector<MapNode> nodes;
+    std::vector<MapEdge> edges;
+    int playerBase = -1;
+    int enemyBase = -1;
+
+    MapView view() const;
+};
+
+// Read-only memory mapping of a binary map file.
+class MapFile {
+public:
+    MapFile() = default;
+    MapFile(const MapFile&) = delete;
+    MapFile& operator=(const MapFile&) = delete;
+    ~MapFile();
+
+    bool open(const std::string& path, std::string& error);
+    void close();
+
+    const MapView& view() const { return mapView; }
+
+private:
+    void* data = nullptr;
+    size_t size = 0;
+    MapView mapView;
+};
+
+// The original two-sided triangular layout.
+MapData defaultMap();
+
+// Synthetic two-sided map for benchmarks and bot matches: a base, then
+// layers-1 layers of width nodes per side, every node already linked to one
+// or two nodes of the next layer and the two front layers linked across.
+// Node count is 2 * (1 + (layers - 1) * width). Same seed, same map.
+// layers and width are clamped so the map stays within MAP_EXTENT.
+MapData generateMap(int layers, int width, uint32_t seed);
+
+bool isBinaryMap(const std::string& path);
+bool loadMapText(const std::string& path, MapData& out, std::string& error);
+bool saveMapText(const std::string& path, const MapView& map, std::string& error);
+bool saveMapBinary(const std::string& path, const MapView& map, std::string& error);
+
+// Checks coordinates, ids and owners so a loaded map can be trusted by the
+// simulation.
+bool validateMap(const MapView& map, std::string& error);
@@ -0,0 +1,16 @@
+#pragma once
+#include "Map.h"
+#include "Node.h"
+#include "Rules.h"
+
+struct MatchResult {
+    bool finished = false; // a base fell before the tick limit
+    Owner winner = Owner::Player;
+    int ticks = 0;
+    int nodes[2] = { 0, 0 }; // nodes held at the end, by Owner
+    int units[2] = { 0, 0 }; // units stationed at the end, by Owner
+};
+
+// Plays one headless match from map to a fallen base or maxTicks.
+// Self-contained: safe to call concurrently from several threads.
+MatchResult runMatch(const MapView& map, const Rules& rules, int maxTicks);
@@ -0,0 +1,95 @@
+#pragma once
+#include <cstdint>
+#include <random>
+#include <vector>
+#include "Command.h"
+#include "GlobalState.h"
+#include "Node.h"
+#include "WorkStealingPool.h"
+
+struct MctsConfig {
+    int iterations = 2000;   // rollouts per decision, over all trees
+    int trees = 0;           // independent trees; 0: one per pool thread
+    int decisionTicks = 30;  // simulated ticks between two moves
+    int rolloutTicks = 300;  // how far a rollout plays on past the tree
+    int maxActions = 12;     // roads considered per tree node, best first
+    float reach = 260.0f;    // same meaning as AIConfig::reach
+    float exploration = 1.4f;
+    uint32_t seed = 1;
+};
+
+// Counters for the last think() and for the bot's lifetime.
+struct MctsStats {
+    long long rollouts = 0;
+    long long ticks = 0;    // simulated ticks, tree descent and rollouts
+    double seconds = 0.0;   // wall time inside think()
+
+    double rolloutsPerSecond() const { return seconds > 0.0 ? rollouts / seconds : 0.0; }
+    double ticksPerSecond() const { return seconds > 0.0 ? ticks / seconds : 0.0; }
+};
+
+// Monte Carlo tree search player for one side.
+//
+// Every iteration clones the root state into a per-thread scratch state,
+// walks the tree by UCT applying each node's move (and a random reply for
+// the other side), expands one node, then plays random roads for both
+// sides for rolloutTicks and scores the result. The tree is open-loop: a
+// node is a sequence of our moves, the replies are resampled every time.
+//
+// Trees are searched in parallel on the pool, each with its own seed and
+// share of the iterations, and their root visit counts are summed, so the
+// answer does not depend on thread timing.
+class MctsBot {
+public:
+    MctsBot(Owner side, WorkStealingPool& pool, const MctsConfig& config = MctsConfig());
+
+    MctsConfig config;
+
+    // Searches from game. Returns true and sets out to a Connect if a road
+    // is the best move, false if waiting is.
+    bool think(const GlobalState& game, Command& out);
+
+    const MctsStats& lastStats() const { return last; }
+    const MctsStats& totalStats() const { return total; }
+
+    Owner side() const { return me; }
+
+private:
+    struct Move {
+        int from = -1, to = -1; // from < 0: wait
+    };
+
+    struct TreeNode {
+        Move move;
+        int parent = -1;
+        int firstChild = -1;
+        int childCount = 0;
+        bool expanded = false;
+        int visits = 0;
+        double value = 0.0; // sum of results, from our side's view
+    };
+
+    struct Tree {
+        std::vector<TreeNode> nodes;
+        std::mt19937 rng;
+        long long rollouts = 0;
+        long long ticks = 0;
+    };
+
+    void search(Tree& tree, const GlobalState& root, GlobalState& scratch, int iterations);
+    void expand(Tree& tree, int node, const GlobalState& state);
+    void listMoves(const GlobalState& state, std::vector<Move>& out) const;
+    bool randomRoad(const GlobalState& state, Owner who, std::mt19937& rng, Command& out) const;
+    long long play(GlobalState& state, const Move& ours, std::mt19937& rng, int ticks) const;
+    double evaluate(const GlobalState& state) const;
+
+    Owner me;
+    WorkStealingPool& pool;
+
+    std::vector<Tree> trees;
+    std::vector<GlobalState> scratch; // one per pool thread
+    uint32_t thinkCount = 0;
+
+    MctsStats last;
+    MctsStats total;
+};
@@ -0,0 +1,59 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Wire format shared by the lockstep server and its clients, over TCP.
+//
+// Every message is a frame: a 4-byte little-endian length of what
+// follows, a type byte, then the payload, integers as varints.
+//     Hello    client -> server  match id, wanted side (0 blue, 1 red, 2 any,
+//                                3 watch)
+//     Welcome  server -> client  side, input delay, tick rate, then the
+//                                match state as a snapshot (Snapshot.h)
+//     Command  client -> server  tick it is meant for, from, to
+//     Batch    server -> client  tick, hash flag [, state hash after the
+//                                step], command count, then per command
+//                                a type byte and from, to
+//     Error    server -> client  message text; the server then closes
+//     Spectate server -> watcher a keyframe or delta (Spectator.h)
+//
+// The server sends a Batch for every tick it steps, empty or not. A client
+// applies the batch's commands and steps once per Batch, so every client
+// goes through exactly the server's sequence of states.
+//
+// A watcher gets no Welcome and sends nothing after its Hello: a keyframe
+// when it joins, then one Spectate message per tick.
+
+static constexpr int WATCH_SIDE = 3;
+static constexpr size_t MAX_FRAME = 64u << 20;
+
+enum class MsgType : uint8_t {
+    Hello = 1,
+    Welcome,
+    Command,
+    Batch,
+    Error,
+    Spectate
+};
+
+// Starts a frame in out; finishFrame fills in its length.
+size_t beginFrame(std::vector<uint8_t>& out, MsgType type);
+void finishFrame(std::vector<uint8_t>& out, size_t start);
+
+// If buf holds a whole frame at offset, sets its type and payload range
+// and the offset of the next frame. false if more bytes are needed or,
+// with error set, if the frame is invalid.
+bool nextFrame(const std::vector<uint8_t>& buf, size_t& offset, MsgType& type,
+               const uint8_t*& payload, size_t& size, std::string& error);
+
+// Non-blocking TCP sockets; -1 and error on failure.
+int listenTcp(uint16_t port, std::string& error);
+int connectTcp(const std::string& host, uint16_t port, std::string& error);
+uint16_t localPort(int fd);
+
+// Moves bytes between a socket and a buffer without blocking. Return
+// false when the connection is closed or failed.
+bool readSome(int fd, std::vector<uint8_t>& in);
+bool writeSome(int fd, std::vector<uint8_t>& out);
@@ -1,14 +1,16 @@
 #pragma once
 #include <vector>
-#include "VisualObject.h"
+
+static constexpr float NODE_RADIUS = 22.0f;
 
 enum class Owner {
     Player,
     Enemy
 };
 
-class Node : public VisualObject {
+class Node {
 public:
+    int id;
     float x, y;
     int layer;
     Owner owner;
@@ -16,17 +18,15 @@ public:
     int unitCount;
     int capacity;
 
-    std::vector<Node*> edges;
-    int roundRobinIndex = 0;
-
-    float productionTimer = 0.0f;
+    std::vector<int> edges; // neighbour node ids
 
-    Node(float x, float y, int layer, Owner owner);
+    // edges split by what chooseTarget can use them for; kept in edge
+    // order and rebuilt only when a road is added or an owner changes
+    std::vector<int> forward; // towards the enemy side of this node's owner
+    std::vector<int> lateral; // same owner, same layer
 
-    void update(float dt) override;
-    void draw() override;
+    Node(int id, float x, float y, int layer, Owner owner);
 
     bool contains(float mx, float my) const;
     bool isConnected() const { return !edges.empty(); }
-    int sendPhase = 0; // 0: forward, 1: same level
 };
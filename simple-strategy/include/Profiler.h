@@ -0,0 +1,102 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Phases the profiler tells apart. Update contains Commands through
+// Arrivals; Draw contains the draw passes.
+enum class Phase {
+    Input,
+    AI,
+    Update,
+    Commands,
+    Production,
+    Sending,
+    Movement,
+    Arrivals,
+    Draw,
+    DrawRoads,
+    DrawNodes,
+    DrawUnits,
+    DrawUI,
+    Count
+};
+
+const char* phaseName(Phase phase);
+
+// Per-phase wall time, summed per frame for the last HISTORY frames and
+// kept as individual events in a fixed ring for Chrome trace export
+// (chrome://tracing, Perfetto). Recording is two clock reads and a store
+// per scope, with no allocation after construction.
+//
+// Not thread-safe: use one per thread.
+class Profiler {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr int HISTORY = 120; // frames
+
+    explicit Profiler(size_t traceCapacity = 1 << 16);
+
+    bool enabled = true;
+
+    void add(Phase phase, Clock::time_point start, Clock::time_point end);
+
+    // Closes the current frame (or tick, for headless runs).
+    void endFrame();
+
+    // Milliseconds in the last closed frame, and per frame over the kept
+    // history.
+    double lastFrame(Phase phase) const;
+    double average(Phase phase) const;
+    double peak(Phase phase) const;
+    int frames() const { return frameCount < HISTORY ? frameCount : HISTORY; }
+
+    // Writes the events in the ring, oldest first, as trace-event JSON.
+    bool exportTrace(const std::string& path, std::string& error) const;
+    void clearTrace();
+
+private:
+    struct TraceEvent {
+        int64_t startNs;
+        int64_t durationNs;
+        Phase phase;
+    };
+
+    static constexpr int PHASES = (int)Phase::Count;
+
+    Clock::time_point origin;
+
+    double current[PHASES] = {};        // ms in the open frame
+    double history[HISTORY][PHASES] = {};
+    int frameCount = 0;
+
+    std::vector<TraceEvent> trace; // ring, allocated once
+    size_t traceNext = 0;
+    size_t traceSize = 0;
+};
+
+// Times the enclosing block into profiler, if there is one and it is on.
+class ProfileScope {
+public:
+    ProfileScope(Profiler* profiler, Phase phase)
+        : profiler(profiler && profiler->enabled ? profiler : nullptr), phase(phase)
+    {
+        if (this->profiler) start = Profiler::Clock::now();
+    }
+
+    ~ProfileScope()
+    {
+        if (profiler) profiler->add(phase, start, Profiler::Clock::now());
+    }
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+    Profiler* profiler;
+    Phase phase;
+    Profiler::Clock::time_point start;
+};
@@ -0,0 +1,79 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "Command.h"
+#include "GlobalState.h"
+#include "Map.h"
+#include "Rules.h"
+
+struct TimedCommand {
+    int tick;
+    Command cmd;
+};
+
+// Every command that changed a match, with the tick it took effect on.
+// Together with the map and rules this reproduces the match exactly.
+//
+// File layout: "SSRP", version, Rules field by field (floats as their
+// little-endian bits, the margin as a signed varint, a 0/1 streams byte),
+// node count and a hash of the starting layout (to catch replaying
+// against the wrong map), command count, then per command a varint tick
+// delta, a type byte and, for Connect, varint node ids, then the end
+// tick as a varint delta from the last command.
+class ReplayLog {
+public:
+    Rules rules;
+    uint32_t nodeCount = 0;
+    uint64_t mapHash = 0;
+    std::vector<TimedCommand> commands;
+    int endTick = 0; // tick the recording stopped at, won or not
+
+    // Starts a log for a match about to be played on this freshly loaded
+    // state, and checks a freshly loaded state is the one it was made on.
+    void begin(const GlobalState& game);
+    bool fits(const GlobalState& game) const;
+
+    void record(int tick, const Command& cmd);
+    void finish(const GlobalState& game);
+
+    void encode(std::vector<uint8_t>& out) const;
+    bool decode(const uint8_t* data, size_t size, std::string& error);
+
+    bool save(const std::string& path, std::string& error) const;
+    bool load(const std::string& path, std::string& error);
+};
+
+// Headless playback of a ReplayLog at full speed. Keeps a snapshot of the
+// state every snapshotInterval ticks so seeking backwards restarts from
+// the nearest one instead of from the beginning.
+class ReplayPlayer {
+public:
+    // Loads map with the log's rules; check log.fits(state()) afterwards.
+    ReplayPlayer(const MapView& map, const ReplayLog& log, int snapshotInterval);
+
+    const GlobalState& state() const { return game; }
+
+    // Simulates forward until the state is at tick or the match is over.
+    void runTo(int tick);
+
+    // Goes to tick from the nearest snapshot at or before it.
+    void seek(int tick);
+
+    int lastCommandTick() const;
+
+private:
+    struct Snapshot {
+        int tick;
+        size_t next;
+        std::vector<uint8_t> bytes;
+    };
+
+    void advance();
+
+    const ReplayLog& log;
+    int snapshotInterval;
+    GlobalState game;
+    size_t next = 0; // first command not yet submitted
+    std::vector<Snapshot> snapshots;
+};
@@ -0,0 +1,43 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+#include "Camera.h"
+
+// Draws roads with one GL_LINES call from a vertex buffer that is only
+// refilled when the road list changes, instead of one graphics::drawLine
+// call per road per frame. Like UnitBatch it draws straight into SGG's GL
+// context; vertices stay in world coordinates and the camera goes in as
+// uniforms. Per frame only the indices of the roads to draw are uploaded.
+class RoadBatch {
+public:
+    RoadBatch() = default;
+    RoadBatch(const RoadBatch&) = delete;
+    RoadBatch& operator=(const RoadBatch&) = delete;
+
+    // Needs a current GL 3.3 context; false (keep using drawLine) without.
+    bool init();
+    bool ready() const { return program != 0; }
+
+    // Replaces the roads: x1, y1, x2, y2 per road, in world coordinates.
+    void setRoads(const std::vector<float>& vertices);
+
+    // Draws the roads with these indices into the setRoads() list.
+    void draw(const Camera& camera, const float color[3], const std::vector<int>& roads);
+
+    // Frees the GL objects while the context is still alive.
+    void release();
+
+private:
+    unsigned int program = 0;
+    unsigned int vao = 0;
+    unsigned int vertexBuffer = 0;
+    unsigned int indexBuffer = 0;
+    size_t vertexCount = 0;
+    size_t indexCapacity = 0; // bytes
+    std::vector<unsigned int> indices;
+
+    int uCenter = -1;
+    int uZoom = -1;
+    int uCanvas = -1;
+    int uColor = -1;
+};
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cmath>
+
+// Gameplay constants a match runs with. Each GlobalState owns its copy,
+// so matches with different values can run side by side.
+struct Rules {
+    float sendInterval = 1.0f;    // seconds between sends from a node
+    float produceInterval = 3.0f; // seconds per produced unit
+    float unitSpeed = 0.5f;       // fraction of a road per second
+    int redistributeMargin = 2;   // lateral send only to a neighbour this much emptier
+    bool unitStreams = false;     // units on a road travel as runs, see UnitPool
+
+    // Intervals and speed must be positive and finite: production loops
+    // until its timer drops below the interval, and units never arrive at
+    // speed 0. Anything read from a file, the wire or the command line is
+    // checked with this before a match runs with it.
+    bool valid() const
+    {
+        return std::isfinite(sendInterval) && sendInterval > 0.0f &&
+               std::isfinite(produceInterval) && produceInterval > 0.0f &&
+               std::isfinite(unitSpeed) && unitSpeed > 0.0f;
+    }
+};
@@ -0,0 +1,71 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include "Rules.h"
+
+// Game modes with fixed rules. A ruleset has the fields of Rules as
+// static constexpr members, so the tick phases instantiated for it see
+// constants; Rules itself is the run-time ruleset, for tuning sweeps and
+// anything else that sets values by hand.
+//
+// GlobalState::step() picks the instantiation each tick with modeOf(),
+// so changing a field of GlobalState::rules just falls back to the
+// run-time one.
+struct StandardRules {
+    static constexpr float sendInterval = 1.0f;
+    static constexpr float produceInterval = 3.0f;
+    static constexpr float unitSpeed = 0.5f;
+    static constexpr int redistributeMargin = 2;
+    static constexpr bool unitStreams = false;
+};
+
+// short matches: bases fill fast and units cross a road in a second
+struct BlitzRules {
+    static constexpr float sendInterval = 0.5f;
+    static constexpr float produceInterval = 1.0f;
+    static constexpr float unitSpeed = 1.0f;
+    static constexpr int redistributeMargin = 2;
+    static constexpr bool unitStreams = false;
+};
+
+// long build-up: slow production, and slow units travelling as runs
+struct SiegeRules {
+    static constexpr float sendInterval = 0.5f;
+    static constexpr float produceInterval = 4.0f;
+    static constexpr float unitSpeed = 0.25f;
+    static constexpr int redistributeMargin = 4;
+    static constexpr bool unitStreams = true;
+};
+
+enum class GameMode : uint8_t {
+    Standard,
+    Blitz,
+    Siege,
+    Custom // any other Rules
+};
+
+template <class R>
+Rules rulesOf()
+{
+    Rules r;
+    r.sendInterval = R::sendInterval;
+    r.produceInterval = R::produceInterval;
+    r.unitSpeed = R::unitSpeed;
+    r.redistributeMargin = R::redistributeMargin;
+    r.unitStreams = R::unitStreams;
+    return r;
+}
+
+template <class R>
+bool sameRules(const Rules& r)
+{
+    return r.sendInterval == R::sendInterval && r.produceInterval == R::produceInterval &&
+           r.unitSpeed == R::unitSpeed && r.redistributeMargin == R::redistributeMargin &&
+           r.unitStreams == R::unitStreams;
+}
+
+Rules rulesFor(GameMode mode); // Custom gives the defaults
+GameMode modeOf(const Rules& rules);
+
+const char* gameModeName(GameMode mode);
+bool parseGameMode(const std::string& name, GameMode& out); // not Custom
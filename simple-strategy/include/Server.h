@@ -0,0 +1,129 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "GlobalState.h"
+#include "Map.h"
+#include "Net.h"
+#include "Replay.h"
+#include "Spectator.h"
+
+struct ServerConfig {
+    uint16_t port = 7777;      // 0: any free port, see LockstepServer::port()
+    int layers = 4;            // generated map for every match
+    int width = 4;
+    uint32_t seed = 1;
+    int inputDelay = 3;        // ticks clients should schedule commands ahead
+    int hashInterval = TICK_RATE; // ticks between state hashes in batches
+    int maxTicks = TICK_RATE * 60 * 10; // a match ends as a draw after this
+    int maxLead = TICK_RATE * 2; // ticks past the match a command may be scheduled
+    size_t maxQueued = 1024;     // commands waiting in a match
+    size_t maxBacklog = 4 << 20; // unsent bytes before a client is dropped
+};
+
+struct ServerStats {
+    long long connections = 0;
+    long long matchesStarted = 0;
+    long long matchesFinished = 0;
+    long long ticks = 0;       // match steps, over all matches
+    long long commands = 0;    // commands that took effect
+    long long rejected = 0;    // commands for the wrong side, too far ahead, or malformed
+    double stepSeconds = 0.0;  // time spent stepping matches
+    long long spectators = 0;  // watchers that joined
+    long long spectateBytes = 0; // keyframes and deltas queued for watchers
+    long long overflows = 0;   // clients dropped for not reading their backlog
+};
+
+// Authoritative lockstep server. One thread and one epoll loop host any
+// number of matches. Two clients sending Hello with the same match id play
+// each other. Once both are in, a timerfd at TICK_RATE steps every running
+// match: commands clients scheduled for that tick (or missed it) are
+// checked against the sender's side, applied, and the ones that took
+// effect are broadcast with the tick as a Batch. Watchers of a match get
+// one encoded delta per tick, the same bytes for all of them. See Net.h
+// for the wire format.
+class LockstepServer {
+public:
+    explicit LockstepServer(const ServerConfig& config);
+    ~LockstepServer();
+
+    LockstepServer(const LockstepServer&) = delete;
+    LockstepServer& operator=(const LockstepServer&) = delete;
+
+    bool start(std::string& error);
+
+    // Handles events until stop() is called (from any thread).
+    void run();
+    void stop() { stopping = true; }
+
+    // One round of events, waiting up to timeoutMs for the first.
+    void poll(int timeoutMs);
+
+    uint16_t port() const { return boundPort; }
+    size_t matchCount() const { return matches.size(); }
+    const ServerStats& stats() const { return counters; }
+
+private:
+    struct Connection {
+        int fd = -1;
+        std::vector<uint8_t> in, out;
+        uint32_t match = 0;
+        bool joined = false;
+        Owner side = Owner::Player;
+        bool watching = false;
+        bool closing = false; // close once out is flushed
+    };
+
+    struct QueuedCommand {
+        int tick;
+        Owner side;
+        Command cmd;
+    };
+
+    struct Match {
+        uint32_t id = 0;
+        GlobalState game;
+        ReplayLog log;          // effective commands; batches are its tail
+        int fds[2] = { -1, -1 }; // by Owner
+        std::vector<int> watchers;
+        SpectatorEncoder spectate; // only kept up while there are watchers
+        std::vector<QueuedCommand> queue;
+        bool running = false;
+        bool finished = false;
+    };
+
+    void accept();
+    void onReadable(Connection& c);
+    void onFrame(Connection& c, MsgType type, const uint8_t* p, size_t size);
+    void join(Connection& c, uint32_t matchId, int wantSide);
+    void watch(Connection& c, uint32_t matchId);
+    void sendSpectate(int fd, const std::vector<uint8_t>& message);
+    void tickMatches(uint64_t steps);
+    void stepMatch(Match& m);
+    void send(int fd, const std::vector<uint8_t>& frame);
+    void flush(Connection& c);
+    void fail(Connection& c, const std::string& message);
+    void drop(int fd);
+    void removeDeadMatches();
+
+    ServerConfig config;
+    MapData map;
+
+    int listenFd = -1;
+    int epollFd = -1;
+    int timerFd = -1;
+    uint16_t boundPort = 0;
+    std::atomic<bool> stopping{false};
+
+    std::unordered_map<int, Connection> connections;
+    std::unordered_map<uint32_t, std::unique_ptr<Match>> matches;
+    std::vector<uint32_t> deadMatches; // left by both players, removed after the event round
+    std::vector<uint8_t> frame; // scratch for outgoing messages
+    std::vector<uint8_t> spectateScratch;
+    std::vector<int> fanout; // copy of the fds a message goes to
+
+    ServerStats counters;
+};
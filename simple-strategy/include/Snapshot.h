@@ -0,0 +1,122 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class GlobalState;
+
+// Binary image of a whole GlobalState: nodes, roads, units, per-node timers,
+// ownership, pending commands, rules and clock. Everything is an index or a
+// plain number, so a snapshot is written with one sequential write and can
+// be restored straight from a memory-mapped file or an in-memory buffer.
+//
+// Layout, native byte order, every section 4-byte aligned:
+//     SnapshotHeader
+//     SnapshotNode[nodeCount]
+//     float sendTimer[nodeCount], float productionTimer[nodeCount],
+//     int32 roundRobin[nodeCount], uint8 sendPhase[nodeCount],
+//     uint8 supplied[nodeCount]                  (byte columns padded to 4)
+//     int32 links[linkCount]   per node: edges, then forward, then lateral
+//     SnapshotRoad[roadCount]
+//     int32 depart[unitCount], int32 arrive[unitCount], float speed[unitCount],
+//     int32 from[unitCount], int32 to[unitCount], int32 owner[unitCount],
+//     int32 stride[unitCount], uint64 members[unitCount]   (8-byte aligned)
+//     SnapshotCommand[pendingCount]
+
+static constexpr char SNAPSHOT_MAGIC[4] = { 'S', 'S', 'S', 'N' };
+static constexpr uint32_t SNAPSHOT_VERSION = 3; // 2: unit ticks, 3: unit runs
+
+struct SnapshotHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t nodeCount;
+    uint32_t linkCount;
+    uint32_t roadCount;
+    uint32_t unitCount;
+    uint32_t pendingCount;
+    int32_t tick;
+    int32_t playerBase;
+    int32_t enemyBase;
+    uint8_t gameStarted;
+    uint8_t gameOver;
+    uint8_t winner; // Owner value
+    uint8_t unitStreams;
+    float sendInterval;
+    float produceInterval;
+    float unitSpeed;
+    int32_t redistributeMargin;
+    uint32_t reserved;
+    double clockAccumulator;
+};
+
+struct SnapshotNode {
+    float x, y;
+    int32_t layer;
+    int32_t owner; // Owner value
+    int32_t capacity;
+    int32_t unitCount;
+    uint32_t edgeCount;
+    uint32_t forwardCount;
+    uint32_t lateralCount;
+};
+
+struct SnapshotRoad {
+    int32_t a, b;
+};
+
+struct SnapshotCommand {
+    int32_t type; // CommandType value
+    int32_t from, to;
+};
+
+// Non-owning, checked view of a snapshot, into a file mapping or a buffer.
+struct SnapshotView {
+    const SnapshotHeader* header = nullptr;
+    const SnapshotNode* nodes = nullptr;
+    const float* sendTimer = nullptr;
+    const float* productionTimer = nullptr;
+    const int32_t* roundRobin = nullptr;
+    const uint8_t* sendPhase = nullptr;
+    const uint8_t* supplied = nullptr;
+    const int32_t* links = nullptr;
+    const SnapshotRoad* roads = nullptr;
+    const int32_t* depart = nullptr;
+    const int32_t* arrive = nullptr;
+    const float* speed = nullptr;
+    const int32_t* from = nullptr;
+    const int32_t* to = nullptr;
+    const int32_t* owner = nullptr;
+    const int32_t* stride = nullptr;
+    const uint64_t* members = nullptr;
+    const SnapshotCommand* pending = nullptr;
+};
+
+// Resizes out to the exact snapshot size, which does not allocate once it
+// has held a snapshot that large, and fills it section by section.
+void writeSnapshot(const GlobalState& game, std::vector<uint8_t>& out);
+
+// Checks sizes and ids so the view can be restored without further checks.
+// data must be 8-byte aligned and outlive the view.
+bool parseSnapshot(const void* data, size_t size, SnapshotView& out, std::string& error);
+
+bool isSnapshot(const std::string& path);
+bool saveSnapshot(const std::string& path, const GlobalState& game, std::string& error);
+
+// Read-only memory mapping of a snapshot file.
+class SnapshotFile {
+public:
+    SnapshotFile() = default;
+    SnapshotFile(const SnapshotFile&) = delete;
+    SnapshotFile& operator=(const SnapshotFile&) = delete;
+    ~SnapshotFile();
+
+    bool open(const std::string& path, std::string& error);
+    void close();
+
+    const SnapshotView& view() const { return snapView; }
+
+private:
+    void* data = nullptr;
+    size_t size = 0;
+    SnapshotView snapView;
+};
@@ -0,0 +1,64 @@
+#pragma once
+#include <vector>
+#include "Node.h"
+
+// Uniform grid over node positions, built once per map. Every node is a
+// disk of the same NODE_RADIUS, so with cells at least a node wide a point
+// only needs the 3x3 cells around it checked. Items are stored
+// per cell in one flat array (cellStart[c] .. cellStart[c + 1]).
+class SpatialGrid {
+public:
+    void build(const std::vector<Node>& nodes);
+
+    // Node whose disk contains (x, y), or -1.
+    int pick(const std::vector<Node>& nodes, float x, float y) const;
+
+    // Appends ids of nodes whose disk touches the rectangle.
+    void query(const std::vector<Node>& nodes, float minX, float minY,
+               float maxX, float maxY, std::vector<int>& out) const;
+
+    // Calls fn(id) for the same nodes as query(), without a result vector.
+    template <class Fn>
+    void forEachInRect(const std::vector<Node>& nodes, float minX, float minY,
+                       float maxX, float maxY, Fn fn) const;
+
+    float cellSize = 0.0f;
+
+private:
+    int cellX(float x) const;
+    int cellY(float y) const;
+    bool touches(const Node& n, float minX, float minY, float maxX, float maxY) const;
+
+    float originX = 0.0f, originY = 0.0f;
+    int cols = 0, rows = 0;
+    std::vector<int> cellStart; // cols * rows + 1 offsets into items
+    std::vector<int> items;     // node ids grouped by cell
+};
+
+inline bool SpatialGrid::touches(const Node& n, float minX, float minY, float maxX, float maxY) const
+{
+    return n.x + NODE_RADIUS >= minX && n.x - NODE_RADIUS <= maxX &&
+           n.y + NODE_RADIUS >= minY && n.y - NODE_RADIUS <= maxY;
+}
+
+template <class Fn>
+void SpatialGrid::forEachInRect(const std::vector<Node>& nodes, float minX, float minY,
+                                float maxX, float maxY, Fn fn) const
+{
+    if (cols == 0) return;
+
+    // a node is filed under the cell of its centre, so widen by a radius
+    int x0 = cellX(minX - NODE_RADIUS), x1 = cellX(maxX + NODE_RADIUS);
+    int y0 = cellY(minY - NODE_RADIUS), y1 = cellY(maxY + NODE_RADIUS);
+
+    for (int cy = y0; cy <= y1; ++cy) {
+        for (int cx = x0; cx <= x1; ++cx) {
+            int c = cy * cols + cx;
+            for (int k = cellStart[c]; k < cellStart[c + 1]; ++k) {
+                int id = items[k];
+                if (touches(nodes[id], minX, minY, maxX, maxY))
+                    fn(id);
+            }
+        }
+    }
+}
@@ -0,0 +1,86 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "GlobalState.h"
+
+// Live state stream for spectators, who draw a match without simulating it.
+//
+// A message is a keyframe or a delta. A keyframe is 'K' and a snapshot
+// (Snapshot.h). A delta is 'D' and then, as varints:
+//     tick, flags (1 started, 2 over, 4 red won)
+//     node count, per node: (id gap << 1 | owner), signed unitCount
+//     road count, per road: a, b
+//     sent count, per unit: (from << 1 | owner), to
+//     landing count, per entry: gap to the previous position
+// Node ids and landing positions are ascending and sent as gaps. Every
+// keyframeInterval ticks a keyframe of the same tick follows the delta in
+// the same message; the decoder compares the two before taking it.
+//
+// The decoder sends the same units and retires the same arrivals as the
+// simulation did, in the same order, so its unit arrays stay entry for
+// entry the server's; the landing positions are the check that they do.
+// A delta therefore costs a few bytes per change and nothing per
+// unchanged node or moving unit.
+
+// Encodes one match. Call encode() after every step of the game; call
+// requestKeyframe() if the game jumped some other way (a restore).
+class SpectatorEncoder {
+public:
+    explicit SpectatorEncoder(int keyframeInterval = TICK_RATE * 10);
+
+    // Keyframe or delta for the game's current state into out (replaced).
+    void encode(const GlobalState& game, std::vector<uint8_t>& out);
+
+    void requestKeyframe() { synced = false; }
+
+    // A keyframe of game that does not disturb the stream, for a spectator
+    // joining between two encode() calls.
+    static void keyframe(const GlobalState& game, std::vector<uint8_t>& out);
+
+    long long keyframes = 0;
+    long long deltas = 0;
+
+private:
+    void sync(const GlobalState& game);
+
+    int keyframeInterval;
+    bool synced = false;
+    int lastKeyframe = 0;
+
+    // what the spectators last saw
+    int tick = 0;
+    uint8_t flags = 0;
+    std::vector<uint8_t> owner;
+    std::vector<int> unitCount;
+    size_t roads = 0;
+    size_t units = 0;
+
+    std::vector<int> changed; // scratch
+
+    std::vector<uint8_t> image;
+};
+
+// Applies encoder messages to a GlobalState used only for drawing.
+class SpectatorDecoder {
+public:
+    // false (with error) on a malformed message or a delta that does not
+    // follow the view's state; a later keyframe recovers.
+    bool apply(GlobalState& view, const uint8_t* p, size_t size, std::string& error);
+
+    bool ready() const { return haveKeyframe; }
+
+    long long keyframes = 0;
+    long long deltas = 0;
+    long long mismatches = 0; // keyframes that disagreed with the view
+
+private:
+    // advances p past the delta
+    bool applyDelta(GlobalState& view, const uint8_t*& p, const uint8_t* end, std::string& error);
+    bool matches(const GlobalState& view, const SnapshotView& snap) const;
+
+    bool haveKeyframe = false;
+    std::vector<uint8_t> snapshot; // aligned copy of the keyframe
+    std::vector<uint32_t> removals;
+};
@@ -0,0 +1,22 @@
+#pragma once
+
+// The simulation always advances in fixed steps of TICK_DT seconds,
+// independent of the frame rate of whoever drives it.
+static constexpr int TICK_RATE = 30;
+static constexpr float TICK_DT = 1.0f / TICK_RATE;
+static constexpr float TICK_MS = 1000.0f / TICK_RATE;
+
+// Upper bound on steps run for a single frame. A frame that took longer
+// drops the excess time instead of spiralling into ever longer catch-ups.
+static constexpr int MAX_CATCHUP_STEPS = 5;
+
+class TickClock {
+public:
+    double accumulator = 0.0; // ms not yet consumed by a step
+
+    // Adds a frame's real time, returns how many fixed steps to run now.
+    int advance(float dt_ms);
+
+    // How far (0..1) the frame is past the last completed step.
+    float alpha() const;
+};
@@ -1,19 +1,23 @@
 #pragma once
-#include "VisualObject.h"
-#include "Node.h"
+#include <cstddef>
+#include <cstdint>
 
-class Unit : public VisualObject {
-public:
-    Node* from;
-    Node* to;
-    Owner owner;
+// A unit goes from 0 to 1 along its road, dt * speed per tick, clamped at
+// 1. Since that only depends on the ticks since it left, nothing steps it:
+// its arrival tick is known when it is sent, and its position is worked
+// out when something wants to draw it.
 
-    float t = 0.0f;
+// Ticks a unit takes to arrive, counted with the same float adds a per-tick
+// advance makes, so the count is exact. A unit sent during tick D is
+// advanced that same tick and lands on tick D + travelTicks - 1. 0 if it
+// would never arrive.
+int travelTicks(float speed, float dt);
 
-    Unit(Node* from, Node* to, Owner owner);
-
-    void update(float dt) override;
-    void draw() override;
-
-    bool arrived() const;
-};
+// Position along the road of a unit sent on tick depart, as of the end of
+// tick; alpha in [0, 1] goes back to the start of that tick, for drawing
+// between steps.
+inline float unitProgress(int depart, float speed, int tick, float alpha, float dt)
+{
+    float t = ((float)(tick - depart) + alpha) * dt * speed;
+    return t < 0.0f ? 0.0f : t > 1.0f ? 1.0f : t;
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+#include "Node.h"
+
+// Instanced disk renderer for units, drawing straight into the GL context
+// SGG created. Positions are collected per owner, uploaded in one buffer
+// per frame and drawn with one instanced call per owner, instead of one
+// graphics::drawDisk call per unit.
+//
+// Coordinates are canvas coordinates, as for the graphics:: calls; the
+// canvas is assumed to fill the current GL viewport, which is how SGG sets
+// it up before calling the draw function.
+class UnitBatch {
+public:
+    UnitBatch() = default;
+    UnitBatch(const UnitBatch&) = delete;
+    UnitBatch& operator=(const UnitBatch&) = delete;
+
+    // Compiles the shader and creates buffers. Needs a current GL 3.3
+    // context; returns false (and the caller should keep using drawDisk)
+    // if instancing is not available.
+    bool init();
+    bool ready() const { return program != 0; }
+
+    void add(float x, float y, Owner owner)
+    {
+        std::vector<float>& v = staged[(int)owner];
+        v.push_back(x);
+        v.push_back(y);
+    }
+
+    // Draws everything added since the last flush as disks of the given
+    // canvas radius, then clears the staging lists.
+    void flush(float canvasW, float canvasH, float radius);
+
+    // Frees the GL objects. Must run while the context is still alive, so
+    // it is not left to a destructor that may run after the window is gone.
+    void release();
+
+private:
+    std::vector<float> staged[2]; // x, y per unit, by Owner
+    std::vector<float> upload;
+
+    unsigned int program = 0;
+    unsigned int vao = 0;
+    unsigned int quadBuffer = 0;
+    unsigned int instanceBuffer = 0;
+    size_t instanceCapacity = 0; // bytes
+
+    int uCanvas = -1;
+    int uRadius = -1;
+    int uColor = -1;
+};
@@ -0,0 +1,73 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Node.h"
+#include "Unit.h"
+
+// Stable reference to a unit. Stays valid while the unit is alive; the
+// generation makes a stale handle miss after its slot has been reused.
+struct UnitHandle {
+    uint32_t index = UINT32_MAX;
+    uint32_t generation = 0;
+};
+
+// Slot map of units kept as parallel arrays. Live entries are packed at
+// positions [0, size()) of every array so drawing streams through them;
+// removal swaps the last entry into the hole, and freed slots are
+// recycled, so steady-state play does not allocate.
+//
+// An entry can stand for a run of units on the same road, owner and
+// speed: the head left on depart and lands on arrive, and bit k of members
+// is set for a unit k * stride ticks behind it. Without Rules::unitStreams
+// every entry is a single unit (members 1, stride 0).
+//
+// The arrays are public for kernels and rendering; only spawn and the
+// remove calls may change their length.
+class UnitPool {
+public:
+    std::vector<int> depart;  // tick the (head) unit was sent on
+    std::vector<int> arrive;  // tick it lands on, see travelTicks()
+    std::vector<float> speed;
+    std::vector<int> from;    // node ids
+    std::vector<int> to;
+    std::vector<Owner> owner;
+    std::vector<uint64_t> members; // bit 0, the head, is always set
+    std::vector<int> stride;       // ticks between members
+
+    UnitHandle spawn(int fromId, int toId, Owner who, float unitSpeed, int departTick,
+                     int arriveTick);
+    void remove(UnitHandle h);
+    void removeAt(size_t i);
+
+    // Removes the units at the given ascending positions.
+    void removeSorted(const std::vector<uint32_t>& positions);
+
+    int indexOf(UnitHandle h) const; // -1 if the unit is gone
+    UnitHandle handleAt(size_t i) const;
+
+    // Replaces every unit with count units copied from the given columns,
+    // packed in that order. Handles taken before stop matching.
+    void assign(size_t entries, const int* depart, const int* arrive, const float* speed,
+                const int* from, const int* to, const Owner* owner, const uint64_t* members,
+                const int* stride);
+
+    void reserve(size_t n);
+    void clear();
+
+    size_t size() const { return from.size(); }
+    bool empty() const { return from.empty(); }
+
+    // bumped by assign() and clear(), which invalidate every handle at once
+    uint32_t resets = 0;
+
+private:
+    struct Slot {
+        uint32_t dense = 0;
+        uint32_t generation = 0;
+    };
+
+    std::vector<uint32_t> denseToSlot;
+    std::vector<Slot> slots;
+    std::vector<uint32_t> freeSlots;
+};
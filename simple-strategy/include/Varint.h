@@ -0,0 +1,44 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// LEB128-style variable-length integers for the compact binary streams
+// (replay logs, spectator deltas): 7 bits per byte, high bit set on all
+// but the last byte. Signed values are zigzag-mapped first so small
+// negative numbers stay short.
+
+inline void putVarint(std::vector<uint8_t>& out, uint64_t v)
+{
+    while (v >= 0x80) {
+        out.push_back((uint8_t)(v | 0x80));
+        v >>= 7;
+    }
+    out.push_back((uint8_t)v);
+}
+
+inline void putSignedVarint(std::vector<uint8_t>& out, int64_t v)
+{
+    putVarint(out, ((uint64_t)v << 1) ^ (uint64_t)(v >> 63));
+}
+
+// Reads one varint at p and advances it; false on truncated input.
+inline bool getVarint(const uint8_t*& p, const uint8_t* end, uint64_t& v)
+{
+    v = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (p >= end) return false;
+        uint8_t b = *p++;
+        v |= (uint64_t)(b & 0x7f) << shift;
+        if (!(b & 0x80)) return true;
+    }
+    return false;
+}
+
+inline bool getSignedVarint(const uint8_t*& p, const uint8_t* end, int64_t& v)
+{
+    uint64_t u;
+    if (!getVarint(p, end, u)) return false;
+    v = (int64_t)(u >> 1) ^ -(int64_t)(u & 1);
+    return true;
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include "GlobalState.h"
+
+// Roads and units by area, so a frame only touches what the camera can
+// see. Roads are filed under every cell their segment crosses;
+// units are kept per road as handles, added from GlobalState::sent as
+// ticks go by and dropped once their handle goes stale.
+//
+// A frame that finds the state more than one tick on (catch-up, several
+// lockstep batches, a load or a spectator keyframe) refiles every unit.
+class ViewIndex {
+public:
+    // Files the roads; call whenever game.roadVersion moves.
+    void rebuildRoads(const GlobalState& game);
+
+    // Brings the unit lists up to game's current tick.
+    void syncUnits(const GlobalState& game);
+
+    // Indices into game.roads that cross a cell the rectangle touches,
+    // each once.
+    void queryRoads(float minX, float minY, float maxX, float maxY, std::vector<int>& out);
+
+    // Calls fn(i) for each position i in units of an entry on the road,
+    // dropping entries that have left the pool.
+    template <class Fn>
+    void forEachUnit(const UnitPool& units, int road, Fn fn);
+
+private:
+    void fileUnit(const UnitPool& units, UnitHandle h, int from, int to);
+    void refileUnits(const GlobalState& game);
+    int cellX(float x) const;
+    int cellY(float y) const;
+
+    float cellSize = 0.0f;
+    float originX = 0.0f, originY = 0.0f;
+    int cols = 0, rows = 0;
+    std::vector<int> cellStart; // cols * rows + 1 offsets into items
+    std::vector<int> items;     // road indices grouped by cell
+
+    std::vector<uint32_t> seen; // per road, the query that last returned it
+    uint32_t query = 0;
+
+    std::unordered_map<uint64_t, int> roadByEnds; // (a << 32 | b) both ways
+    std::vector<std::vector<UnitHandle>> roadUnits;
+    int unitsTick = -1;
+    uint32_t unitsResets = 0;
+};
+
+template <class Fn>
+void ViewIndex::forEachUnit(const UnitPool& units, int road, Fn fn)
+{
+    std::vector<UnitHandle>& list = roadUnits[road];
+    size_t kept = 0;
+    for (size_t k = 0; k < list.size(); ++k) {
+        int i = units.indexOf(list[k]);
+        if (i < 0) continue;
+        list[kept++] = list[k];
+        fn((size_t)i);
+    }
+    list.resize(kept);
+}
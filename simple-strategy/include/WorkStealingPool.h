@@ -0,0 +1,55 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Runs batches of independent jobs across all cores. Each worker starts
+// with a contiguous share of the batch and works through it from the back;
+// a worker that runs dry steals from the front of the others' queues, so
+// long and short matches even out without a central queue.
+class WorkStealingPool {
+public:
+    explicit WorkStealingPool(int threads = 0); // 0: one per hardware thread
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    int threadCount() const { return (int)queues.size(); }
+
+    // Calls job(i) once for each i in [0, count), on the pool threads and
+    // the calling thread, and returns when all calls have finished. The
+    // worker index passed as second argument is stable for the call and
+    // below threadCount(), for per-thread scratch state.
+    void run(size_t count, const std::function<void(size_t, int)>& job);
+
+private:
+    struct Queue {
+        std::mutex lock;
+        std::deque<size_t> items;
+    };
+
+    void workerLoop(int self);
+    void drain(int self, const std::function<void(size_t, int)>& job);
+    bool takeWork(int self, size_t& item);
+
+    std::vector<std::unique_ptr<Queue>> queues; // [0] belongs to the caller
+    std::vector<std::thread> threads;
+
+    std::mutex lock;
+    std::condition_variable wake;
+    std::condition_variable done;
+    const std::function<void(size_t, int)>* job = nullptr;
+    uint64_t generation = 0;
+    int busy = 0;
+    bool stopping = false;
+
+    std::atomic<size_t> remaining{0};
+};
@@ -4,11 +4,11 @@ set -e
 echo "Building strategy_nodes..."
 
 g++ -std=c++17 \
-    src/main.cpp src/GlobalState.cpp src/Node.cpp src/Unit.cpp \
+    src/main.cpp src/Camera.cpp src/Frontend.cpp src/RoadBatch.cpp src/UnitBatch.cpp src/ViewIndex.cpp src/ArrivalWheel.cpp src/Client.cpp src/EnemyAI.cpp src/GlobalState.cpp src/Map.cpp src/Match.cpp src/MctsBot.cpp src/Net.cpp src/Node.cpp src/Profiler.cpp src/Replay.cpp src/Ruleset.cpp src/Server.cpp src/Snapshot.cpp src/SpatialGrid.cpp src/Spectator.cpp src/TickClock.cpp src/Unit.cpp src/UnitPool.cpp src/WorkStealingPool.cpp \
     -Iinclude -Isgg -Isgg/sgg \
     -Lsgg/lib -lsgg \
     -lSDL2 -lSDL2_mixer -lGLEW -lfreetype \
-    -lGL -lGLU \
+    -lGL -lGLU -pthread \
     -o strategy_nodes
 
 echo "Build successful."
@@ -0,0 +1,42 @@
+#include "ArrivalWheel.h"
+
+void ArrivalWheel::schedule(UnitHandle unit, int arrival, int now)
+{
+    size_t span = arrival > now ? (size_t)(arrival - now) : 0;
+    if (span >= buckets.size()) grow(span);
+
+    buckets[(size_t)arrival & (buckets.size() - 1)].push_back({ unit, arrival });
+    count++;
+}
+
+void ArrivalWheel::take(int tick, std::vector<UnitHandle>& out)
+{
+    if (buckets.empty()) return;
+
+    std::vector<Entry>& bucket = buckets[(size_t)tick & (buckets.size() - 1)];
+    for (const Entry& e : bucket)
+        out.push_back(e.unit);
+    count -= bucket.size();
+    bucket.clear();
+}
+
+void ArrivalWheel::clear()
+{
+    for (std::vector<Entry>& bucket : buckets)
+        bucket.clear();
+    count = 0;
+}
+
+void ArrivalWheel::grow(size_t span)
+{
+    size_t size = 64;
+    while (size <= span) size *= 2;
+
+    std::vector<std::vector<Entry>> old;
+    old.swap(buckets);
+    buckets.resize(size);
+
+    for (const std::vector<Entry>& bucket : old)
+        for (const Entry& e : bucket)
+            buckets[(size_t)e.arrival & (size - 1)].push_back(e);
+}
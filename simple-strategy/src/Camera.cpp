@@ -0,0 +1,53 @@
+#include "Camera.h"
+#include <algorithm>
+
+void Camera::setView(float w, float h)
+{
+    viewW = w;
+    viewH = h;
+}
+
+void Camera::fit(float minX, float minY, float maxX, float maxY)
+{
+    const float margin = 40.0f;
+
+    if (minX >= margin && minY >= margin && maxX <= viewW - margin && maxY <= viewH - margin) {
+        centerX = viewW * 0.5f;
+        centerY = viewH * 0.5f;
+        zoom = 1.0f;
+        return;
+    }
+
+    centerX = (minX + maxX) * 0.5f;
+    centerY = (minY + maxY) * 0.5f;
+
+    float zx = (viewW - 2.0f * margin) / std::max(1.0f, maxX - minX);
+    float zy = (viewH - 2.0f * margin) / std::max(1.0f, maxY - minY);
+    zoom = std::max(MIN_ZOOM, std::min(1.0f, std::min(zx, zy)));
+}
+
+void Camera::pan(float canvasDx, float canvasDy)
+{
+    centerX -= canvasDx / zoom;
+    centerY -= canvasDy / zoom;
+}
+
+void Camera::zoomAt(float factor, float canvasX, float canvasY)
+{
+    float wx = toWorldX(canvasX);
+    float wy = toWorldY(canvasY);
+
+    zoom = std::max(MIN_ZOOM, std::min(MAX_ZOOM, zoom * factor));
+
+    // keep (wx, wy) under the cursor
+    centerX = wx - (canvasX - viewW * 0.5f) / zoom;
+    centerY = wy - (canvasY - viewH * 0.5f) / zoom;
+}
+
+void Camera::visibleRect(float& minX, float& minY, float& maxX, float& maxY) const
+{
+    minX = toWorldX(0.0f);
+    minY = toWorldY(0.0f);
+    maxX = toWorldX(viewW);
+    maxY = toWorldY(viewH);
+}
@@ -0,0 +1,253 @@
+#include "Client.h"
+#include "Net.h"
+#include "Snapshot.h"
+#include "Varint.h"
+#include <unistd.h>
+
+LockstepClient::LockstepClient(GlobalState& game)
+    : game(game)
+{
+}
+
+LockstepClient::~LockstepClient()
+{
+    close();
+}
+
+bool LockstepClient::connect(const std::string& host, uint16_t port, uint32_t matchId, int side,
+                             std::string& error)
+{
+    close();
+
+    sock = connectTcp(host, port, error);
+    if (sock < 0) return false;
+
+    size_t start = beginFrame(out, MsgType::Hello);
+    putVarint(out, matchId);
+    putVarint(out, (uint64_t)side);
+    finishFrame(out, start);
+
+    if (!writeSome(sock, out)) {
+        error = host + ": connection closed";
+        close();
+        return false;
+    }
+    return true;
+}
+
+void LockstepClient::close()
+{
+    if (sock >= 0) ::close(sock);
+    sock = -1;
+    welcomed = false;
+    in.clear();
+    out.clear();
+}
+
+void LockstepClient::sendPending()
+{
+    // the server decides when a match starts; only roads go up
+    for (const Command& cmd : game.pending) {
+        if (cmd.type != CommandType::Connect) continue;
+
+        size_t start = beginFrame(out, MsgType::Command);
+        putVarint(out, (uint64_t)(game.tick + inputDelay));
+        putVarint(out, (uint64_t)cmd.from);
+        putVarint(out, (uint64_t)cmd.to);
+        finishFrame(out, start);
+    }
+    game.pending.clear();
+}
+
+bool LockstepClient::poll(std::string& error)
+{
+    if (sock < 0) {
+        error = "not connected";
+        return false;
+    }
+
+    if (welcomed) sendPending();
+    if (!out.empty() && !writeSome(sock, out)) {
+        error = "connection closed";
+        return false;
+    }
+
+    bool open = readSome(sock, in);
+
+    size_t offset = 0;
+    MsgType type;
+    const uint8_t* payload;
+    size_t size;
+    while (nextFrame(in, offset, type, payload, size, error)) {
+        if (!onFrame((uint8_t)type, payload, size, error)) return false;
+    }
+    if (!error.empty()) return false;
+    in.erase(in.begin(), in.begin() + offset);
+
+    if (!open) {
+        error = "connection closed";
+        return false;
+    }
+    return true;
+}
+
+bool LockstepClient::onFrame(uint8_t type, const uint8_t* p, size_t size, std::string& error)
+{
+    const uint8_t* end = p + size;
+
+    switch ((MsgType)type) {
+    case MsgType::Welcome: {
+        uint64_t side, delay, rate;
+        if (!getVarint(p, end, side) || !getVarint(p, end, delay) || !getVarint(p, end, rate)) {
+            error = "bad welcome";
+            return false;
+        }
+        if (rate != (uint64_t)TICK_RATE) {
+            error = "server runs at a different tick rate";
+            return false;
+        }
+
+        // the payload sits at an arbitrary offset; snapshots want alignment
+        snapshot.assign(p, end);
+        SnapshotView view;
+        if (!parseSnapshot(snapshot.data(), snapshot.size(), view, error)) return false;
+
+        game.restore(view);
+        mySide = (Owner)side;
+        inputDelay = (int)delay;
+        welcomed = true;
+        return true;
+    }
+
+    case MsgType::Batch: {
+        uint64_t tick, hasHash, hash = 0, count;
+        if (!welcomed || !getVarint(p, end, tick) || !getVarint(p, end, hasHash) ||
+            (hasHash && !getVarint(p, end, hash)) || !getVarint(p, end, count)) {
+            error = "bad batch";
+            return false;
+        }
+        if ((int)tick != game.tick) {
+            error = "batch for tick " + std::to_string(tick) + " at tick " + std::to_string(game.tick);
+            return false;
+        }
+
+        // local commands were sent already; only the server's go in
+        game.pending.clear();
+        for (uint64_t i = 0; i < count; ++i) {
+            uint64_t from, to;
+            if (p >= end) {
+                error = "bad batch";
+                return false;
+            }
+            CommandType t = (CommandType)*p++;
+            if (!getVarint(p, end, from) || !getVarint(p, end, to)) {
+                error = "bad batch";
+                return false;
+            }
+            game.submit({ t, (int)from - 1, (int)to - 1 });
+        }
+
+        game.step();
+        batches++;
+
+        if (hasHash) {
+            hashChecks++;
+            if (game.stateHash() != hash) {
+                desyncs++;
+                error = "out of sync at tick " + std::to_string(game.tick);
+                return false;
+            }
+        }
+        return true;
+    }
+
+    case MsgType::Error:
+        error = "server: " + std::string((const char*)p, size);
+        return false;
+
+    default:
+        error = "unexpected message";
+        return false;
+    }
+}
+
+SpectatorClient::SpectatorClient(GlobalState& view)
+    : view(view)
+{
+}
+
+SpectatorClient::~SpectatorClient()
+{
+    close();
+}
+
+bool SpectatorClient::connect(const std::string& host, uint16_t port, uint32_t matchId,
+                              std::string& error)
+{
+    close();
+
+    sock = connectTcp(host, port, error);
+    if (sock < 0) return false;
+
+    size_t start = beginFrame(out, MsgType::Hello);
+    putVarint(out, matchId);
+    putVarint(out, (uint64_t)WATCH_SIDE);
+    finishFrame(out, start);
+
+    if (!writeSome(sock, out)) {
+        error = host + ": connection closed";
+        close();
+        return false;
+    }
+    return true;
+}
+
+void SpectatorClient::close()
+{
+    if (sock >= 0) ::close(sock);
+    sock = -1;
+    in.clear();
+    out.clear();
+}
+
+bool SpectatorClient::poll(std::string& error)
+{
+    if (sock < 0) {
+        error = "not connected";
+        return false;
+    }
+    if (!out.empty() && !writeSome(sock, out)) {
+        error = "connection closed";
+        return false;
+    }
+
+    size_t before = in.size();
+    bool open = readSome(sock, in);
+    bytes += (long long)(in.size() - before);
+
+    size_t offset = 0;
+    MsgType type;
+    const uint8_t* payload;
+    size_t size;
+    while (nextFrame(in, offset, type, payload, size, error)) {
+        if (type == MsgType::Error) {
+            error = "server: " + std::string((const char*)payload, size);
+            return false;
+        }
+        if (type != MsgType::Spectate) {
+            error = "unexpected message";
+            return false;
+        }
+
+        std::string skipped;
+        if (!decoder.apply(view, payload, size, skipped)) errors++;
+    }
+    if (!error.empty()) return false;
+    in.erase(in.begin(), in.begin() + offset);
+
+    if (!open) {
+        error = "connection closed";
+        return false;
+    }
+    return true;
+}
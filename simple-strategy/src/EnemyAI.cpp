@@ -0,0 +1,92 @@
+#include "EnemyAI.h"
+#include <cmath>
+
+float scoreRoad(const GlobalState& game, const Node& from, const Node& to, Owner side)
+{
+    float dist = std::hypot(to.x - from.x, to.y - from.y);
+
+    if (to.owner == side) {
+        // own node cut off from the base: linking it brings it back into
+        // production and sending
+        if (game.supplied[to.id]) return 0.0f;
+        return 50.0f + to.unitCount - dist * 0.05f;
+    }
+
+    // attack where we outnumber them; their base ends the match
+    float s = 100.0f + 2.0f * (from.unitCount - to.unitCount) - dist * 0.05f;
+    if (&to == game.getBase(to.owner)) s += 200.0f;
+    return s;
+}
+
+EnemyAI::EnemyAI(Owner side, const AIConfig& config)
+    : config(config), me(side)
+{
+}
+
+void EnemyAI::reset()
+{
+    cursor = 0;
+    planned = false;
+    bestFrom = bestTo = -1;
+    lastActionTick = -1000000;
+}
+
+void EnemyAI::update(GlobalState& game)
+{
+    if (!game.gameStarted || game.gameOver) return;
+
+    // a restored or reloaded match can leave the clock behind us
+    if (game.tick < lastActionTick) reset();
+    if (cursor > game.nodes.size()) reset();
+
+    using Clock = std::chrono::steady_clock;
+    bool limited = config.budgetUs > 0;
+    Clock::time_point deadline = Clock::now() + std::chrono::microseconds(config.budgetUs);
+
+    while (!planned) {
+        if (cursor == game.nodes.size()) {
+            planned = true;
+            break;
+        }
+
+        const Node& n = game.nodes[cursor++];
+        if (n.owner == me && n.unitCount >= config.minUnits && game.canSelect(&n))
+            scanSource(game, n);
+
+        if (limited && Clock::now() >= deadline) return;
+    }
+
+    // hold a plan until the side may build again; with nothing found, go
+    // straight into the next pass
+    int wait = (int)std::lround(config.actionInterval * TICK_RATE);
+    if (bestFrom >= 0 && game.tick - lastActionTick < wait) return;
+
+    // the plan may be a few frames old; only act on it if it still holds
+    Node* from = game.nodeById(bestFrom);
+    Node* to = game.nodeById(bestTo);
+    if (from && to && game.canCreateEdge(from, to, me)) {
+        game.submit({ CommandType::Connect, bestFrom, bestTo });
+        lastActionTick = game.tick;
+    }
+
+    cursor = 0;
+    planned = false;
+    bestFrom = bestTo = -1;
+}
+
+void EnemyAI::scanSource(const GlobalState& game, const Node& from)
+{
+    float r = config.reach;
+    game.grid.forEachInRect(game.nodes, from.x - r, from.y - r, from.x + r, from.y + r,
+        [&](int id) {
+            const Node& to = game.nodes[id];
+            if (!game.canCreateEdge(&from, &to, me)) return;
+
+            float s = scoreRoad(game, from, to, me);
+            if (s > 0.0f && (bestFrom < 0 || s > bestScore)) {
+                bestScore = s;
+                bestFrom = from.id;
+                bestTo = id;
+            }
+        });
+}
@@ -0,0 +1,575 @@
+#include "Frontend.h"
+#include <graphics.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <cstdlib>
+
+// below these zoom levels labels are unreadable and single units are
+// sub-pixel, so labels are skipped and units are drawn as density markers
+static constexpr float LABEL_MIN_ZOOM = 0.45f;
+static constexpr float UNIT_MIN_ZOOM = 0.35f;
+static constexpr float DENSITY_CELL = 24.0f; // canvas units
+static constexpr float UNIT_RADIUS = 5.0f;   // world units
+
+static const char* QUICKSAVE_PATH = "quicksave.snap";
+static const char* TRACE_PATH = "trace.json";
+
+static constexpr float PAN_SPEED = 600.0f;   // canvas units per second
+static constexpr float ZOOM_SPEED = 1.5f;    // doublings per second
+
+Frontend::Frontend(GlobalState& game, float canvasW, float canvasH)
+    : game(game)
+{
+    camera.setView(canvasW, canvasH);
+    game.profiler = &profiler;
+}
+
+// true on the frame the key goes down
+static bool keyPressed(graphics::scancode_t key, bool& wasDown)
+{
+    bool down = graphics::getKeyState(key);
+    bool pressed = down && !wasDown;
+    wasDown = down;
+    return pressed;
+}
+
+void Frontend::resetCamera()
+{
+    if (game.nodes.empty()) return;
+
+    float minX = game.nodes[0].x, maxX = minX;
+    float minY = game.nodes[0].y, maxY = minY;
+    for (const Node& n : game.nodes) {
+        minX = std::min(minX, n.x - NODE_RADIUS);
+        maxX = std::max(maxX, n.x + NODE_RADIUS);
+        minY = std::min(minY, n.y - NODE_RADIUS);
+        maxY = std::max(maxY, n.y + NODE_RADIUS);
+    }
+    camera.fit(minX, minY, maxX, maxY);
+}
+
+void Frontend::handleCamera(float dt_ms)
+{
+    float dt = dt_ms * 0.001f;
+
+    graphics::MouseState ms;
+    graphics::getMouseState(ms);
+
+    float mx = graphics::windowToCanvasX((float)ms.cur_pos_x);
+    float my = graphics::windowToCanvasY((float)ms.cur_pos_y);
+
+    // drag with the right button
+    if (ms.button_right_down) {
+        float px = graphics::windowToCanvasX((float)ms.prev_pos_x);
+        float py = graphics::windowToCanvasY((float)ms.prev_pos_y);
+        camera.pan(mx - px, my - py);
+    }
+
+    float dx = 0.0f, dy = 0.0f;
+    if (graphics::getKeyState(graphics::SCANCODE_LEFT)  || graphics::getKeyState(graphics::SCANCODE_A)) dx += 1.0f;
+    if (graphics::getKeyState(graphics::SCANCODE_RIGHT) || graphics::getKeyState(graphics::SCANCODE_D)) dx -= 1.0f;
+    if (graphics::getKeyState(graphics::SCANCODE_UP)    || graphics::getKeyState(graphics::SCANCODE_W)) dy += 1.0f;
+    if (graphics::getKeyState(graphics::SCANCODE_DOWN)  || graphics::getKeyState(graphics::SCANCODE_S)) dy -= 1.0f;
+    if (dx != 0.0f || dy != 0.0f)
+        camera.pan(dx * PAN_SPEED * dt, dy * PAN_SPEED * dt);
+
+    float zoomDir = 0.0f;
+    if (graphics::getKeyState(graphics::SCANCODE_EQUALS) || graphics::getKeyState(graphics::SCANCODE_KP_PLUS))  zoomDir += 1.0f;
+    if (graphics::getKeyState(graphics::SCANCODE_MINUS)  || graphics::getKeyState(graphics::SCANCODE_KP_MINUS)) zoomDir -= 1.0f;
+    if (zoomDir != 0.0f)
+        camera.zoomAt(std::pow(2.0f, zoomDir * ZOOM_SPEED * dt), mx, my);
+
+    if (graphics::getKeyState(graphics::SCANCODE_HOME))
+        resetCamera();
+}
+
+void Frontend::handleQuickSave()
+{
+    if (keyPressed(graphics::SCANCODE_F5, saveKeyDown)) {
+        std::string error;
+        statusText = saveSnapshot(QUICKSAVE_PATH, game, error) ? "Game saved." : error;
+    }
+
+    if (keyPressed(graphics::SCANCODE_F9, loadKeyDown)) {
+        std::string error;
+        if (game.recorder) {
+            // a jump in time cannot be expressed as commands
+            statusText = "Loading is off while recording.";
+        } else if (client || watcher) {
+            statusText = "Loading is off in a server match.";
+        } else {
+            size_t before = game.nodes.size();
+            if (game.restoreFile(QUICKSAVE_PATH, error)) {
+                selectedNode = nullptr;
+                enemyAI.reset();
+                if (game.nodes.size() != before) resetCamera();
+                statusText = "Game loaded.";
+            } else {
+                statusText = error;
+            }
+        }
+    }
+}
+
+void Frontend::handleProfiler()
+{
+    if (keyPressed(graphics::SCANCODE_F3, profileKeyDown))
+        showProfile = !showProfile;
+
+    if (keyPressed(graphics::SCANCODE_F4, traceKeyDown)) {
+        std::string error;
+        if (profiler.exportTrace(TRACE_PATH, error))
+            statusText = std::string("Trace written to ") + TRACE_PATH + ".";
+        else
+            statusText = error;
+    }
+}
+
+void Frontend::handleInput()
+{
+    graphics::MouseState ms;
+    graphics::getMouseState(ms);
+
+    if (!ms.button_left_pressed) return;
+
+    float mx = camera.toWorldX(graphics::windowToCanvasX((float)ms.cur_pos_x));
+    float my = camera.toWorldY(graphics::windowToCanvasY((float)ms.cur_pos_y));
+
+    Node* clicked = game.pickNode(mx, my);
+
+    if (!selectedNode) {
+        if (!clicked) return;
+
+        bool mine = client ? clicked->owner == client->side()
+                           : !aiEnabled || clicked->owner == Owner::Player;
+        if (game.canSelect(clicked) && mine) {
+            selectedNode = clicked;
+            statusText = "Node selected. Click another node to connect.";
+        }
+    } else {
+        if (clicked && game.canCreateEdge(selectedNode, clicked, selectedNode->owner)) {
+            game.submit({ CommandType::Connect, selectedNode->id, clicked->id });
+            // a server match applies it only once it comes back in a batch
+            statusText = client ? "Connection sent." : "Connection created (shared road).";
+        }
+        selectedNode = nullptr;
+    }
+}
+
+void Frontend::shutdown()
+{
+    unitBatch.release();
+    roadBatch.release();
+}
+
+void Frontend::update(float dt_ms)
+{
+    // a frame is this update and the draw after it
+    profiler.endFrame();
+
+    {
+        ProfileScope scope(&profiler, Phase::Input);
+        handleCamera(dt_ms);
+        handleQuickSave();
+        handleProfiler();
+    }
+
+    if (watcher) {
+        if (game.gameOver && graphics::getKeyState(graphics::SCANCODE_ESCAPE))
+            graphics::stopMessageLoop();
+    } else if (!game.gameStarted) {
+        // a server match starts once both players are in
+        if (!client && graphics::getKeyState(graphics::SCANCODE_RETURN)) {
+            game.submit({ CommandType::Start });
+        }
+    } else if (game.gameOver) {
+        if (graphics::getKeyState(graphics::SCANCODE_ESCAPE)) {
+            graphics::stopMessageLoop();
+        }
+    } else {
+        {
+            ProfileScope scope(&profiler, Phase::Input);
+            handleInput();
+        }
+        if (aiEnabled && !client) {
+            ProfileScope scope(&profiler, Phase::AI);
+            enemyAI.update(game);
+        }
+    }
+
+    if (!client && !watcher) {
+        game.update(dt_ms);
+    } else if (!disconnected) {
+        std::string error;
+        if (client ? !client->poll(error) : !watcher->poll(error)) {
+            disconnected = true;
+            statusText = error;
+        }
+    }
+}
+
+void Frontend::drawNode(const Node& n)
+{
+    graphics::Brush br;
+    br.outline_opacity = 1.0f;
+
+    if (n.owner == Owner::Player) {
+        br.fill_color[0] = 0.2f;
+        br.fill_color[1] = 0.6f;
+        br.fill_color[2] = 1.0f;
+    } else {
+        br.fill_color[0] = 1.0f;
+        br.fill_color[1] = 0.3f;
+        br.fill_color[2] = 0.3f;
+    }
+
+    float cx = camera.toCanvasX(n.x);
+    float cy = camera.toCanvasY(n.y);
+
+    graphics::drawDisk(cx, cy, NODE_RADIUS * camera.zoom, br);
+
+    if (camera.zoom < LABEL_MIN_ZOOM) return;
+
+    graphics::Brush text;
+    text.fill_color[0] = 1.0f;
+    text.fill_color[1] = 1.0f;
+    text.fill_color[2] = 1.0f;
+    text.outline_opacity = 0.0f;
+
+    const std::string& s = countLabel(n.unitCount);
+
+    float textX = cx - 4.5f * camera.zoom * (float)s.size();
+    float textY = cy + 6.0f * camera.zoom;
+
+    graphics::drawText(textX, textY, 16.0f * camera.zoom, s, text);
+}
+
+const std::string& Frontend::countLabel(int count)
+{
+    if (count < 0) count = 0;
+    while ((int)countLabels.size() <= count)
+        countLabels.push_back(std::to_string(countLabels.size()));
+    return countLabels[count];
+}
+
+void Frontend::syncView()
+{
+    // first draw runs with SGG's context current
+    if (!roadBatchTried) {
+        roadBatchTried = true;
+        roadBatch.init();
+    }
+
+    if (roadVersion != game.roadVersion) {
+        roadVertices.clear();
+        roadVertices.reserve(game.roads.size() * 4);
+        for (const Road& r : game.roads) {
+            const Node& a = game.nodes[r.a];
+            const Node& b = game.nodes[r.b];
+            roadVertices.push_back(a.x);
+            roadVertices.push_back(a.y);
+            roadVertices.push_back(b.x);
+            roadVertices.push_back(b.y);
+        }
+        roadVersion = game.roadVersion;
+        roadBatch.setRoads(roadVertices);
+        viewIndex.rebuildRoads(game);
+    }
+    viewIndex.syncUnits(game);
+
+    // widened by a unit radius, so units at the edge of the view count
+    float minX, minY, maxX, maxY;
+    camera.visibleRect(minX, minY, maxX, maxY);
+    visibleRoads.clear();
+    viewIndex.queryRoads(minX - UNIT_RADIUS, minY - UNIT_RADIUS, maxX + UNIT_RADIUS,
+                         maxY + UNIT_RADIUS, visibleRoads);
+}
+
+void Frontend::drawRoads()
+{
+    static const float color[3] = { 0.85f, 0.85f, 0.85f };
+    if (roadBatch.ready()) {
+        roadBatch.draw(camera, color, visibleRoads);
+        return;
+    }
+
+    graphics::Brush line;
+    line.fill_color[0] = color[0];
+    line.fill_color[1] = color[1];
+    line.fill_color[2] = color[2];
+
+    const float* v = roadVertices.data();
+    for (int r : visibleRoads) {
+        const float* e = v + (size_t)r * 4;
+        graphics::drawLine(camera.toCanvasX(e[0]), camera.toCanvasY(e[1]),
+                           camera.toCanvasX(e[2]), camera.toCanvasY(e[3]), line);
+    }
+}
+
+void Frontend::drawUnit(float x, float y, Owner owner)
+{
+    graphics::Brush br;
+    br.fill_color[0] = owner == Owner::Player ? 0.2f : 1.0f;
+    br.fill_color[1] = owner == Owner::Player ? 1.0f : 0.2f;
+    br.fill_color[2] = 0.2f;
+
+    graphics::drawDisk(camera.toCanvasX(x), camera.toCanvasY(y), UNIT_RADIUS * camera.zoom, br);
+}
+
+void Frontend::drawUnits(float alpha)
+{
+    const UnitPool& u = game.units;
+
+    float minX, minY, maxX, maxY;
+    camera.visibleRect(minX, minY, maxX, maxY);
+
+    // first draw runs with SGG's context current
+    if (!unitBatchTried) {
+        unitBatchTried = true;
+        unitBatch.init();
+    }
+
+    const bool aggregate = camera.zoom < UNIT_MIN_ZOOM;
+    const bool batched = unitBatch.ready();
+    int cols = (int)std::ceil(camera.viewW / DENSITY_CELL);
+    int rows = (int)std::ceil(camera.viewH / DENSITY_CELL);
+    if (aggregate)
+        density.assign((size_t)cols * rows * 2, 0);
+
+    // only units on roads near the view; an entry is one unit or a run of
+    // them, one per member bit
+    auto drawEntry = [&](size_t i) {
+        const Node& from = game.nodes[u.from[i]];
+        const Node& to = game.nodes[u.to[i]];
+
+        for (uint64_t bits = u.members[i]; bits; bits &= bits - 1) {
+            int depart = u.depart[i] + __builtin_ctzll(bits) * u.stride[i];
+            float t = unitProgress(depart, u.speed[i], game.tick, alpha, TICK_DT);
+            float x = from.x + (to.x - from.x) * t;
+            float y = from.y + (to.y - from.y) * t;
+
+            if (x < minX - UNIT_RADIUS || x > maxX + UNIT_RADIUS ||
+                y < minY - UNIT_RADIUS || y > maxY + UNIT_RADIUS)
+                continue;
+
+            if (!aggregate) {
+                if (batched)
+                    unitBatch.add(camera.toCanvasX(x), camera.toCanvasY(y), u.owner[i]);
+                else
+                    drawUnit(x, y, u.owner[i]);
+                continue;
+            }
+
+            int cx = std::max(0, std::min(cols - 1, (int)(camera.toCanvasX(x) / DENSITY_CELL)));
+            int cy = std::max(0, std::min(rows - 1, (int)(camera.toCanvasY(y) / DENSITY_CELL)));
+            density[((size_t)cy * cols + cx) * 2 + (int)u.owner[i]]++;
+        }
+    };
+    for (int road : visibleRoads)
+        viewIndex.forEachUnit(u, road, drawEntry);
+
+    if (!aggregate) {
+        if (batched)
+            unitBatch.flush(camera.viewW, camera.viewH, UNIT_RADIUS * camera.zoom);
+        return;
+    }
+
+    // one marker per cell and side, growing with the number of units in it
+    graphics::Brush br;
+    br.outline_opacity = 0.0f;
+    br.fill_opacity = 0.8f;
+    br.fill_color[2] = 0.2f;
+
+    for (int cy = 0; cy < rows; ++cy) {
+        for (int cx = 0; cx < cols; ++cx) {
+            for (int side = 0; side < 2; ++side) {
+                int count = density[((size_t)cy * cols + cx) * 2 + side];
+                if (count == 0) continue;
+
+                br.fill_color[0] = side == (int)Owner::Player ? 0.2f : 1.0f;
+                br.fill_color[1] = side == (int)Owner::Player ? 1.0f : 0.2f;
+
+                float radius = std::min(DENSITY_CELL * 0.45f, 2.0f + 1.5f * std::sqrt((float)count));
+                float offset = side == 0 ? -0.15f : 0.15f;
+                graphics::drawDisk((cx + 0.5f + offset) * DENSITY_CELL,
+                                   (cy + 0.5f) * DENSITY_CELL, radius, br);
+            }
+        }
+    }
+}
+
+void Frontend::draw(float alpha)
+{
+    ProfileScope scope(&profiler, Phase::Draw);
+
+    float minX, minY, maxX, maxY;
+    camera.visibleRect(minX, minY, maxX, maxY);
+
+    {
+        ProfileScope pass(&profiler, Phase::DrawRoads);
+        syncView();
+        drawRoads();
+    }
+    {
+        ProfileScope pass(&profiler, Phase::DrawNodes);
+
+        // grid order is not id order; keep the old id order for overlaps
+        visibleNodes.clear();
+        game.grid.query(game.nodes, minX, minY, maxX, maxY, visibleNodes);
+        std::sort(visibleNodes.begin(), visibleNodes.end());
+        for (int id : visibleNodes) drawNode(game.nodes[id]);
+    }
+    {
+        ProfileScope pass(&profiler, Phase::DrawUnits);
+        drawUnits(alpha);
+    }
+    {
+        ProfileScope pass(&profiler, Phase::DrawUI);
+        drawHud();
+        if (showProfile) drawProfile();
+    }
+}
+
+void Frontend::drawHud()
+{
+    if (selectedNode) {
+        graphics::Brush ring;
+        ring.fill_opacity = 0.0f;
+        ring.outline_opacity = 1.0f;
+        ring.outline_color[0] = 1.0f;
+        ring.outline_color[1] = 1.0f;
+        ring.outline_color[2] = 0.0f;
+        graphics::drawDisk(camera.toCanvasX(selectedNode->x), camera.toCanvasY(selectedNode->y),
+                           26.0f * camera.zoom, ring);
+    }
+
+    graphics::Brush text;
+    text.fill_color[0] = text.fill_color[1] = text.fill_color[2] = 1.0f;
+    graphics::drawText(20, 30, 18, statusText, text);
+
+    if (!game.gameStarted) {
+        float panelX = 350.0f;
+        float panelY = 220.0f;
+        float panelW = 500.0f;
+        float panelH = 180.0f;
+
+        graphics::Brush panel;
+        panel.fill_color[0] = 1.0f;
+        panel.fill_color[1] = 1.0f;
+        panel.fill_color[2] = 1.0f;
+        panel.fill_opacity = 1.0f;
+        panel.outline_opacity = 1.0f;
+        panel.outline_color[0] = 0.0f;
+        panel.outline_color[1] = 0.0f;
+        panel.outline_color[2] = 0.0f;
+
+        graphics::drawRect(
+            panelX + panelW * 0.5f,
+            panelY + panelH * 0.5f,
+            panelW,
+            panelH,
+            panel
+        );
+
+        graphics::Brush text;
+        text.fill_color[0] = 0.0f;
+        text.fill_color[1] = 0.0f;
+        text.fill_color[2] = 0.0f;
+
+        graphics::drawText(panelX + 90, panelY + 80, 36, "Press ENTER to start", text);
+
+        return;
+    }
+
+    if (game.gameOver) {
+        float panelX = 350.0f;
+        float panelY = 220.0f;
+        float panelW = 500.0f;
+        float panelH = 180.0f;
+
+        graphics::Brush panel;
+        panel.fill_color[0] = 1.0f;
+        panel.fill_color[1] = 1.0f;
+        panel.fill_color[2] = 1.0f;
+        panel.fill_opacity = 1.0f;
+        panel.outline_opacity = 1.0f;
+        panel.outline_color[0] = 0.0f;
+        panel.outline_color[1] = 0.0f;
+        panel.outline_color[2] = 0.0f;
+
+        graphics::drawRect(
+            panelX + panelW * 0.5f,
+            panelY + panelH * 0.5f,
+            panelW,
+            panelH,
+            panel
+        );
+
+        graphics::Brush text;
+        if (game.winner == Owner::Player) {
+            text.fill_color[0] = 0.2f;
+            text.fill_color[1] = 0.5f;
+            text.fill_color[2] = 1.0f;
+            graphics::drawText(panelX + 120, panelY + 80, 48, "BLUE WON", text);
+        } else {
+            text.fill_color[0] = 1.0f;
+            text.fill_color[1] = 0.3f;
+            text.fill_color[2] = 0.3f;
+            graphics::drawText(panelX + 140, panelY + 80, 48, "RED WON", text);
+        }
+
+        text.fill_color[0] = 0.0f;
+        text.fill_color[1] = 0.0f;
+        text.fill_color[2] = 0.0f;
+        graphics::drawText(panelX + 140, panelY + 130, 24, "Press ESC to quit", text);
+    }
+}
+
+void Frontend::drawProfile()
+{
+    // one row per phase: average and worst frame over the kept history in
+    // ms, and a bar where a whole 60 Hz frame is the full width
+    const int rows = (int)Phase::Count;
+    const float rowH = 18.0f;
+    const float panelW = 340.0f;
+    const float panelH = (rows + 1) * rowH + 12.0f;
+    const float x = camera.viewW - panelW - 10.0f;
+    const float y = 50.0f;
+    const float barX = x + 240.0f;
+    const float barW = 90.0f;
+    const double frameMs = 1000.0 / 60.0;
+
+    graphics::Brush panel;
+    panel.fill_color[0] = panel.fill_color[1] = panel.fill_color[2] = 0.0f;
+    panel.fill_opacity = 0.75f;
+    panel.outline_opacity = 0.0f;
+    graphics::drawRect(x + panelW * 0.5f, y + panelH * 0.5f, panelW, panelH, panel);
+
+    graphics::Brush text;
+    text.fill_color[0] = text.fill_color[1] = text.fill_color[2] = 1.0f;
+
+    graphics::Brush bar;
+    bar.fill_color[0] = 1.0f;
+    bar.fill_color[1] = 0.7f;
+    bar.fill_color[2] = 0.2f;
+    bar.outline_opacity = 0.0f;
+
+    char line[64];
+    std::snprintf(line, sizeof(line), "ms/frame     avg   worst  (%d frames)", profiler.frames());
+    graphics::drawText(x + 8.0f, y + rowH, 14, line, text);
+
+    for (int i = 0; i < rows; ++i) {
+        Phase phase = (Phase)i;
+        double avg = profiler.average(phase);
+        float rowY = y + (i + 2) * rowH;
+
+        std::snprintf(line, sizeof(line), "%-11s %6.2f %6.2f", phaseName(phase), avg, profiler.peak(phase));
+        graphics::drawText(x + 8.0f, rowY, 14, line, text);
+
+        float w = barW * (float)std::min(1.0, avg / frameMs);
+        if (w > 0.5f)
+            graphics::drawRect(barX + w * 0.5f, rowY - 5.0f, w, 10.0f, bar);
+    }
+}
@@ -1,88 +1,246 @@
 #include "GlobalState.h"
-#include <graphics.h>
+#include "Replay.h"
+#include "Ruleset.h"
+#include <algorithm>
 #include <queue>
-#include <unordered_set>
 #include <cmath>
-#include <string>
 #include <cstdlib>
+#include <numeric>
+#include <unordered_set>
 
-static constexpr float SEND_INTERVAL = 1.0f;
-static constexpr float WINDOW_W = 1200.0f;
-
-static std::string statusText = "Click a NODE to select.";
+void GlobalState::init()
+{
+    load(defaultMap().view());
+}
 
-GlobalState::~GlobalState()
+void GlobalState::load(const MapView& map)
 {
-    for (Unit* u : units) {
-        delete u;
+    units.clear();
+    arrivalWheel.clear();
+    arrivals.clear();
+    sent.clear();
+    streamTails.clear();
+    pending.clear();
+    nodes.clear();
+    roads.clear();
+    roadVersion++;
+
+    // every match starts here; rules that would stall step() (see
+    // Rules::valid) are replaced by the defaults rather than run
+    if (!rules.valid()) rules = Rules();
+
+    nodes.reserve(map.nodeCount);
+    for (uint32_t i = 0; i < map.nodeCount; ++i) {
+        const MapNode& m = map.nodes[i];
+        nodes.emplace_back((int)i, m.x, m.y, m.layer, (Owner)m.owner);
+        nodes.back().capacity = m.capacity;
+        nodes.back().unitCount = m.unitCount;
     }
 
-    units.clear();
+    // pre-existing roads go straight in; supply is computed once below.
+    // Duplicates are found by (lower id, higher id) rather than by walking
+    // edge lists, which is quadratic around a base linked to a whole layer.
+    std::unordered_set<uint64_t> seen;
+    seen.reserve(map.edgeCount);
+    for (uint32_t i = 0; i < map.edgeCount; ++i) {
+        Node& a = nodes[map.edges[i].a];
+        Node& b = nodes[map.edges[i].b];
+        uint32_t lo = (uint32_t)std::min(a.id, b.id), hi = (uint32_t)std::max(a.id, b.id);
+        if (!seen.insert((uint64_t)lo << 32 | hi).second) continue;
+        a.edges.push_back(b.id);
+        b.edges.push_back(a.id);
+        roads.push_back({ a.id, b.id });
+    }
 
-    for (Node* n : nodes) {
-        delete n;
+    for (Node& n : nodes)
+        rebuildAdjacency(n);
+
+    grid.build(nodes);
+
+    sendTimer.assign(nodes.size(), 0.0f);
+    productionTimer.assign(nodes.size(), 0.0f);
+    roundRobin.assign(nodes.size(), 0);
+    sendPhase.assign(nodes.size(), 0);
+    supplied.assign(nodes.size(), 0);
+
+    playerBase = map.playerBase;
+    enemyBase = map.enemyBase;
+
+    gameOver = false;
+    gameStarted = false;
+    winner = Owner::Player;
+    tick = 0;
+    clock = TickClock();
+
+    rebuildSupply(Owner::Player);
+    rebuildSupply(Owner::Enemy);
+}
+
+bool GlobalState::loadFile(const std::string& path, std::string& error)
+{
+    if (isBinaryMap(path)) {
+        MapFile file;
+        if (!file.open(path, error)) return false;
+        load(file.view());
+        return true;
     }
-    nodes.clear();
 
-    selectedNode = nullptr;
-    playerBase = nullptr;
-    enemyBase = nullptr;
+    MapData map;
+    if (!loadMapText(path, map, error)) return false;
+    load(map.view());
+    return true;
 }
 
-void GlobalState::init()
+void GlobalState::cloneFrom(const GlobalState& other)
+{
+    if (this == &other) return;
+
+    // copy-assignment keeps capacity: vectors of the same or smaller size
+    // are copied into, element by element
+    *this = other;
+    recorder = nullptr;
+    profiler = nullptr;
+}
+
+void GlobalState::snapshot(std::vector<uint8_t>& out) const
 {
-    float startX = 250.0f;
-    float gapY   = 100.0f;
-    float gapX   = 120.0f;
-
-    const int LAYERS = 3;
-
-    // Blue
-    for (int layer = 0; layer < LAYERS; ++layer) {
-        for (int i = 0; i <= layer; ++i) {
-            Node* n = new Node(
-                startX + layer * gapX,
-                200.0f + i * gapY,
-                layer,
-                Owner::Player
-            );
-            nodes.push_back(n);
-            if (layer == 0 && i == 0) playerBase = n;
+    writeSnapshot(*this, out);
+}
+
+void GlobalState::restore(const SnapshotView& snap)
+{
+    const SnapshotHeader& h = *snap.header;
+    size_t count = h.nodeCount;
+
+    bool moved = nodes.size() != count;
+    if (moved) {
+        nodes.clear();
+        nodes.reserve(count);
+        for (size_t i = 0; i < count; ++i) {
+            const SnapshotNode& s = snap.nodes[i];
+            nodes.emplace_back((int)i, s.x, s.y, s.layer, (Owner)s.owner);
         }
     }
 
-    // Red mirrored
-    for (int layer = 0; layer < LAYERS; ++layer) {
-        for (int i = 0; i <= layer; ++i) {
-            Node* n = new Node(
-                WINDOW_W - startX - layer * gapX,
-                200.0f + i * gapY,
-                layer,
-                Owner::Enemy
-            );
-            nodes.push_back(n);
-            if (layer == 0 && i == 0) enemyBase = n;
+    const int32_t* links = snap.links;
+    for (size_t i = 0; i < count; ++i) {
+        const SnapshotNode& s = snap.nodes[i];
+        Node& n = nodes[i];
+
+        if (n.x != s.x || n.y != s.y) moved = true;
+        n.x = s.x;
+        n.y = s.y;
+        n.layer = s.layer;
+        n.owner = (Owner)s.owner;
+        n.capacity = s.capacity;
+        n.unitCount = s.unitCount;
+
+        n.edges.assign(links, links + s.edgeCount);
+        links += s.edgeCount;
+        n.forward.assign(links, links + s.forwardCount);
+        links += s.forwardCount;
+        n.lateral.assign(links, links + s.lateralCount);
+        links += s.lateralCount;
+    }
+    if (moved) grid.build(nodes);
+
+    sendTimer.assign(snap.sendTimer, snap.sendTimer + count);
+    productionTimer.assign(snap.productionTimer, snap.productionTimer + count);
+    roundRobin.assign(snap.roundRobin, snap.roundRobin + count);
+    sendPhase.assign(snap.sendPhase, snap.sendPhase + count);
+    supplied.assign(snap.supplied, snap.supplied + count);
+
+    const Road* r = (const Road*)snap.roads;
+    roads.assign(r, r + h.roadCount);
+    roadVersion++;
+
+    units.assign(h.unitCount, snap.depart, snap.arrive, snap.speed,
+                 snap.from, snap.to, (const Owner*)snap.owner, snap.members, snap.stride);
+    arrivals.clear();
+    sent.clear();
+
+    pending.clear();
+    for (uint32_t i = 0; i < h.pendingCount; ++i)
+        pending.push_back({ (CommandType)snap.pending[i].type, snap.pending[i].from, snap.pending[i].to });
+
+    rules.sendInterval = h.sendInterval;
+    rules.produceInterval = h.produceInterval;
+    rules.unitSpeed = h.unitSpeed;
+    rules.redistributeMargin = h.redistributeMargin;
+    rules.unitStreams = h.unitStreams != 0;
+
+    playerBase = h.playerBase;
+    enemyBase = h.enemyBase;
+    gameStarted = h.gameStarted != 0;
+    gameOver = h.gameOver != 0;
+    winner = (Owner)h.winner;
+    tick = h.tick;
+    clock.accumulator = h.clockAccumulator;
+
+    // the wheel is not stored; every unit says when it lands
+    arrivalWheel.clear();
+    for (size_t i = 0; i < units.size(); ++i) {
+        if (units.arrive[i] == INT32_MAX) continue;
+        arrivalWheel.schedule(units.handleAt(i), std::max(units.arrive[i], tick + 1), tick);
+    }
+    rebuildStreamTails();
+}
+
+static int lastDeparture(const UnitPool& units, size_t i)
+{
+    return units.depart[i] + units.stride[i] * (63 - __builtin_clzll(units.members[i]));
+}
+
+void GlobalState::rebuildStreamTails()
+{
+    streamTails.clear();
+    if (!rules.unitStreams) return;
+
+    // runs on one road never overlap, so the newest is the one whose last
+    // unit left latest
+    for (size_t i = 0; i < units.size(); ++i) {
+        uint64_t key = ((uint64_t)(uint32_t)units.from[i] << 32) | (uint32_t)units.to[i];
+        int last = lastDeparture(units, i);
+
+        auto it = streamTails.find(key);
+        if (it != streamTails.end()) {
+            int j = units.indexOf(it->second);
+            if (lastDeparture(units, (size_t)j) >= last) continue;
         }
+        streamTails[key] = units.handleAt(i);
     }
 }
 
-Node* GlobalState::getBase(Owner owner) const
+bool GlobalState::restoreFile(const std::string& path, std::string& error)
 {
-    return (owner == Owner::Player) ? playerBase : enemyBase;
+    SnapshotFile file;
+    if (!file.open(path, error)) return false;
+    restore(file.view());
+    return true;
 }
 
-Node* GlobalState::pickNode(float x, float y) const
+const Node* GlobalState::getBase(Owner owner) const
 {
-    for (Node* n : nodes)
-        if (n && n->contains(x, y))
-            return n;
-    return nullptr;
+    int id = (owner == Owner::Player) ? playerBase : enemyBase;
+    if (id < 0) return nullptr;
+    return &nodes[id];
 }
 
-bool GlobalState::edgeExistsUndirected(Node* a, Node* b) const
+Node* GlobalState::nodeById(int id)
 {
-    for (Node* n : a->edges) if (n == b) return true;
-    for (Node* n : b->edges) if (n == a) return true;
+    if (id < 0 || id >= (int)nodes.size()) return nullptr;
+    return &nodes[id];
+}
+
+Node* GlobalState::pickNode(float x, float y)
+{
+    return nodeById(grid.pick(nodes, x, y));
+}
+
+bool GlobalState::edgeExistsUndirected(const Node* a, const Node* b) const
+{
+    for (int n : a->edges) if (n == b->id) return true;
+    for (int n : b->edges) if (n == a->id) return true;
     return false;
 }
 
@@ -91,45 +249,72 @@ void GlobalState::createSharedConnection(Node* a, Node* b)
     if (!a || !b || a == b) return;
     if (edgeExistsUndirected(a, b)) return;
 
-    a->edges.push_back(b);
-    b->edges.push_back(a);
+    a->edges.push_back(b->id);
+    b->edges.push_back(a->id);
+    roads.push_back({ a->id, b->id });
+    roadVersion++;
+
+    rebuildAdjacency(*a);
+    rebuildAdjacency(*b);
+
+    // a road between opposing nodes cannot extend either supply network
+    if (a->owner == b->owner)
+        rebuildSupply(a->owner);
 }
 
-bool GlobalState::hasChainToBase(Node* n, Owner owner) const
+bool GlobalState::canSelect(const Node* n) const
 {
-    Node* base = getBase(owner);
-    if (!n || !base) return false;
-    if (n->owner != owner) return false;
-    if (n == base) return true;
+    if (!n) return false;
+    return n == getBase(n->owner) || hasChainToBase(n, n->owner);
+}
 
-    std::queue<Node*> q;
-    std::unordered_set<Node*> visited;
+bool GlobalState::hasChainToBase(const Node* n, Owner owner) const
+{
+    if (!n || n->owner != owner) return false;
+    return supplied[n->id] != 0;
+}
 
-    q.push(base);
-    visited.insert(base);
+void GlobalState::rebuildSupply(Owner owner)
+{
+    for (size_t i = 0; i < nodes.size(); ++i)
+        if (nodes[i].owner == owner)
+            supplied[i] = 0;
 
-    while (!q.empty()) {
-        Node* cur = q.front();
-        q.pop();
+    const Node* base = getBase(owner);
+    if (!base || base->owner != owner) return;
 
-        for (Node* nxt : cur->edges) {
-            if (!nxt || visited.count(nxt)) continue;
-            if (nxt->owner != owner) continue;
+    spreadSupply(base->id, owner);
+}
+
+// Marks id supplied and everything reachable from it over same-owner
+// roads that is not supplied yet.
+void GlobalState::spreadSupply(int id, Owner owner)
+{
+    // breadth-first; the scratch queue is only ever appended to, so it
+    // doubles as the visit order
+    supplyQueue.clear();
+    supplyQueue.push_back(id);
+    supplied[id] = 1;
 
-            if (nxt == n) return true;
-            visited.insert(nxt);
-            q.push(nxt);
+    for (size_t head = 0; head < supplyQueue.size(); ++head) {
+        const Node& cur = nodes[supplyQueue[head]];
+
+        for (int nxt : cur.edges) {
+            if (supplied[nxt]) continue;
+            if (nodes[nxt].owner != owner) continue;
+
+            supplied[nxt] = 1;
+            supplyQueue.push_back(nxt);
         }
     }
-    return false;
 }
 
-bool GlobalState::canCreateEdge(Node* from, Node* to, Owner owner) const
+bool GlobalState::canCreateEdge(const Node* from, const Node* to, Owner owner) const
 {
     if (!from || !to || from == to) return false;
     if (from->owner != owner) return false;
 
-    Node* base = getBase(owner);
+    const Node* base = getBase(owner);
     if (!base) return false;
 
     // must be supplied or be base
@@ -143,261 +328,412 @@ bool GlobalState::canCreateEdge(Node* from, Node* to, Owner owner) const
     return true;
 }
 
-Node* GlobalState::chooseTarget(Node* source)
+void GlobalState::rebuildAdjacency(Node& n)
 {
-    if (!source || source->edges.empty()) return nullptr;
-
-    const bool wantRight = (source->owner == Owner::Player);
+    const bool wantRight = (n.owner == Owner::Player);
 
-    std::vector<Node*> forward;
-    std::vector<Node*> same;
+    n.forward.clear();
+    n.lateral.clear();
 
-    for (Node* n : source->edges) {
-        if (!n) continue;
+    for (int id : n.edges) {
+        const Node& other = nodes[id];
 
-        // same-level redistribution
-        if (n->owner == source->owner &&
-            n->layer == source->layer &&
-            n->unitCount + 2 <= source->unitCount)
-        {
-            same.push_back(n);
-        }
+        if (other.owner == n.owner && other.layer == n.layer)
+            n.lateral.push_back(id);
 
-        // forward direction
-        bool isForward = wantRight ? (n->x > source->x + 0.5f)
-                                   : (n->x < source->x - 0.5f);
-        if (isForward) {
-            forward.push_back(n);
-        }
+        bool isForward = wantRight ? (other.x > n.x + 0.5f)
+                                   : (other.x < n.x - 0.5f);
+        if (isForward)
+            n.forward.push_back(id);
     }
+}
 
-    auto pickFrom = [&](std::vector<Node*>& v) -> Node* {
-        if (v.empty()) return nullptr;
-        Node* t = v[source->roundRobinIndex % (int)v.size()];
-        source->roundRobinIndex++;
+Node* GlobalState::chooseTarget(Node* source)
+{
+    return chooseTarget(rules, source);
+}
+
+template <class R>
+Node* GlobalState::chooseTarget(const R& r, Node* source)
+{
+    if (!source || source->edges.empty()) return nullptr;
+
+    // same-level redistribution only towards noticeably emptier neighbours
+    auto qualifies = [&](int id) {
+        return nodes[id].unitCount + r.redistributeMargin <= source->unitCount;
+    };
+
+    int forwardCount = (int)source->forward.size();
+    int sameCount = 0;
+    for (int id : source->lateral)
+        if (qualifies(id)) sameCount++;
+
+    auto pickForward = [&]() -> Node* {
+        int& rr = roundRobin[source->id];
+        Node* t = &nodes[source->forward[rr % forwardCount]];
+        rr++;
         return t;
     };
 
-    if (!forward.empty() && !same.empty()) {
+    auto pickSame = [&]() -> Node* {
+        int& rr = roundRobin[source->id];
+        int k = rr % sameCount;
+        rr++;
+        for (int id : source->lateral)
+            if (qualifies(id) && k-- == 0)
+                return &nodes[id];
+        return nullptr;
+    };
+
+    if (forwardCount > 0 && sameCount > 0) {
         Node* target = nullptr;
-        if (source->sendPhase == 0) {
-            target = pickFrom(forward);
-            source->sendPhase = 1;
+        uint8_t& phase = sendPhase[source->id];
+        if (phase == 0) {
+            target = pickForward();
+            phase = 1;
         } else {
-            target = pickFrom(same);
-            source->sendPhase = 0;
+            target = pickSame();
+            phase = 0;
         }
         if (target) return target;
     }
 
-    if (!forward.empty()) return pickFrom(forward);
-    if (!same.empty())    return pickFrom(same);
+    if (forwardCount > 0) return pickForward();
+    if (sameCount > 0)    return pickSame();
 
     return nullptr;
 }
 
-void GlobalState::handleInput()
+void GlobalState::submit(const Command& cmd)
 {
-    graphics::MouseState ms;
-    graphics::getMouseState(ms);
+    pending.push_back(cmd);
+}
 
-    if (!ms.button_left_pressed) return;
+bool GlobalState::applyCommand(const Command& cmd)
+{
+    switch (cmd.type) {
+    case CommandType::Start:
+        if (gameStarted) return false;
+        gameStarted = true;
+        return true;
 
-    float mx = graphics::windowToCanvasX((float)ms.cur_pos_x);
-    float my = graphics::windowToCanvasY((float)ms.cur_pos_y);
+    case CommandType::Connect: {
+        if (!gameStarted || gameOver) return false;
 
-    Node* clicked = pickNode(mx, my);
+        Node* from = nodeById(cmd.from);
+        Node* to = nodeById(cmd.to);
+        if (!from || !to || !canCreateEdge(from, to, from->owner)) return false;
 
-    if (!selectedNode) {
-        if (!clicked) return;
+        createSharedConnection(from, to);
+        return true;
+    }
+    }
+    return false;
+}
 
-        Node* base = getBase(clicked->owner);
-        if (clicked == base || hasChainToBase(clicked, clicked->owner)) {
-            selectedNode = clicked;
-            statusText = "Node selected. Click another node to connect.";
-        }
-    } else {
-        if (clicked && canCreateEdge(selectedNode, clicked, selectedNode->owner)) {
-            createSharedConnection(selectedNode, clicked);
-            statusText = "Connection created (shared road).";
+uint64_t GlobalState::stateHash() const
+{
+    // FNV-1a over the raw bytes of every field that can change
+    uint64_t h = 14695981039346656037ull;
+    auto mix = [&h](const void* data, size_t size) {
+        const uint8_t* p = (const uint8_t*)data;
+        for (size_t i = 0; i < size; ++i) {
+            h ^= p[i];
+            h *= 1099511628211ull;
         }
-        selectedNode = nullptr;
+    };
+
+    mix(&tick, sizeof(tick));
+    mix(&gameOver, sizeof(gameOver));
+    for (const Node& n : nodes) {
+        mix(&n.owner, sizeof(n.owner));
+        mix(&n.unitCount, sizeof(n.unitCount));
     }
+    for (const Road& r : roads)
+        mix(&r, sizeof(r));
+
+    size_t count = units.size();
+    mix(&count, sizeof(count));
+    if (count) {
+        mix(units.depart.data(), count * sizeof(int));
+        mix(units.arrive.data(), count * sizeof(int));
+        mix(units.members.data(), count * sizeof(uint64_t));
+        mix(units.stride.data(), count * sizeof(int));
+        mix(units.from.data(), count * sizeof(int));
+        mix(units.to.data(), count * sizeof(int));
+        mix(units.owner.data(), count * sizeof(Owner));
+    }
+
+    mix(sendTimer.data(), sendTimer.size() * sizeof(float));
+    mix(productionTimer.data(), productionTimer.size() * sizeof(float));
+    return h;
 }
 
 void GlobalState::update(float dt_ms)
 {
-    if (!gameStarted) {
-        if (graphics::getKeyState(graphics::SCANCODE_RETURN)) {
-            gameStarted = true;
-        }
+    ProfileScope scope(profiler, Phase::Update);
+    int steps = clock.advance(dt_ms);
+    for (int i = 0; i < steps; ++i)
+        step();
+}
 
-        return;
+void GlobalState::step()
+{
+    {
+        ProfileScope scope(profiler, Phase::Commands);
+        for (const Command& cmd : pending)
+            if (applyCommand(cmd) && recorder)
+                recorder->record(tick, cmd);
+        pending.clear();
     }
 
-    if (gameOver) {
-        if (graphics::getKeyState(graphics::SCANCODE_ESCAPE)) {
-            graphics::destroyWindow();
-            std::exit(0);
-        }
+    if (!gameStarted || gameOver) return;
+
+    tick++;
+    sent.clear();
+
+    // the one branch on the rules per tick; the phases are built per mode
+    switch (specialize ? modeOf(rules) : GameMode::Custom) {
+    case GameMode::Standard: runPhases(StandardRules()); break;
+    case GameMode::Blitz: runPhases(BlitzRules()); break;
+    case GameMode::Siege: runPhases(SiegeRules()); break;
+    default: runPhases(rules); break;
+    }
+}
+
+template <class R>
+void GlobalState::runPhases(const R& r)
+{
+    const float dt = TICK_DT;
 
-        return;
+    {
+        ProfileScope scope(profiler, Phase::Production);
+        produce(r, dt);
+    }
+    {
+        ProfileScope scope(profiler, Phase::Sending);
+        send(r, dt);
+    }
+    {
+        ProfileScope scope(profiler, Phase::Movement);
+        collectArrivals();
     }
+    {
+        ProfileScope scope(profiler, Phase::Arrivals);
+        resolveArrivals();
+    }
+}
 
-    float dt = dt_ms * 0.001f;
-    handleInput();
+// base always produces, others only once connected
+template <class R>
+void GlobalState::produce(const R& r, float dt)
+{
+    const size_t count = nodes.size();
+    for (size_t i = 0; i < count; ++i) {
+        if (!supplied[i]) continue;
+
+        Node& n = nodes[i];
+        if (n.layer != 0 && n.edges.empty()) continue;
 
-    // production
-    for (Node* n : nodes)
-        if (hasChainToBase(n, n->owner))
-            n->update(dt);
+        float& timer = productionTimer[i];
+        timer += dt;
 
-    // sending
-    for (Node* n : nodes) {
-        if (!hasChainToBase(n, n->owner) || n->unitCount <= 0) {
-            sendTimers[n] = 0.0f;
+        while (timer >= r.produceInterval) {
+            timer -= r.produceInterval;
+            if (n.unitCount < n.capacity)
+                n.unitCount++;
+        }
+    }
+}
+
+template <class R>
+void GlobalState::send(const R& r, float dt)
+{
+    const size_t count = nodes.size();
+    for (size_t i = 0; i < count; ++i) {
+        Node& n = nodes[i];
+        float& t = sendTimer[i];
+
+        if (!supplied[i] || n.unitCount <= 0) {
+            t = 0.0f;
             continue;
         }
 
-        float& t = sendTimers[n];
         t += dt;
 
-        if (t >= SEND_INTERVAL) {
-            t -= SEND_INTERVAL;
-            Node* target = chooseTarget(n);
+        if (t >= r.sendInterval) {
+            t -= r.sendInterval;
+            Node* target = chooseTarget(r, &n);
             if (target) {
-                units.push_back(new Unit(n, target, n->owner));
-                n->unitCount--;
+                spawnUnit(r, n.id, target->id, n.owner);
+                n.unitCount--;
             }
         }
     }
+}
 
-    // units arrival
-    for (auto it = units.begin(); it != units.end();) {
-        Unit* u = *it;
-        u->update(dt);
-
-        if (u->arrived()) {
-            Node* dest = u->to;
-
-            if (dest->owner == u->owner) {
-                if (dest->unitCount < dest->capacity)
-                    dest->unitCount++;
-            } else {
-                dest->unitCount--;
-                if (dest->unitCount <= 0) {
-                    dest->owner = u->owner;
-                    dest->unitCount = 1;
-                    dest->roundRobinIndex = 0;
-
-                    if (dest == playerBase || dest == enemyBase) {
-                        gameOver = true;
-                        winner = u->owner;
-                    }
-                }
-            }
-
-            delete u;
-            it = units.erase(it);
-        } else {
-            ++it;
-        }
+int GlobalState::travelFor(float speed)
+{
+    if (speed != travelSpeed) {
+        travelSpeed = speed;
+        travelSteps = travelTicks(speed, TICK_DT);
     }
+    return travelSteps;
 }
 
-void GlobalState::draw()
+// Adds a unit gap ticks behind a run's head to its members. The stride
+// shrinks to the greatest common divisor of the gaps seen, spreading the
+// bits already set; false if the run would need more than 64 slots.
+static bool joinRun(uint64_t& members, int& stride, int gap)
 {
-    for (Node* n : nodes) n->draw();
-    for (Unit* u : units) u->draw();
+    if (gap <= 0) return false;
+
+    int grid = stride > 0 ? std::gcd(stride, gap) : gap;
+    uint64_t taken = members;
+    if (stride > 0 && grid != stride) {
+        int factor = stride / grid;
+        if ((63 - __builtin_clzll(taken)) * factor >= 64) return false;
 
-    if (selectedNode) {
-        graphics::Brush ring;
-        ring.fill_opacity = 0.0f;
-        ring.outline_opacity = 1.0f;
-        ring.outline_color[0] = 1.0f;
-        ring.outline_color[1] = 1.0f;
-        ring.outline_color[2] = 0.0f;
-        graphics::drawDisk(selectedNode->x, selectedNode->y, 26.0f, ring);
+        taken = 0;
+        for (uint64_t bits = members; bits; bits &= bits - 1)
+            taken |= 1ull << (__builtin_ctzll(bits) * factor);
     }
 
-    graphics::Brush text;
-    text.fill_color[0] = text.fill_color[1] = text.fill_color[2] = 1.0f;
-    graphics::drawText(20, 30, 18, statusText, text);
-
-    if (!gameStarted) {
-        float panelX = 350.0f;
-        float panelY = 220.0f;
-        float panelW = 500.0f;
-        float panelH = 180.0f;
-
-        graphics::Brush panel;
-        panel.fill_color[0] = 1.0f;
-        panel.fill_color[1] = 1.0f;
-        panel.fill_color[2] = 1.0f;
-        panel.fill_opacity = 1.0f;
-        panel.outline_opacity = 1.0f;
-        panel.outline_color[0] = 0.0f;
-        panel.outline_color[1] = 0.0f;
-        panel.outline_color[2] = 0.0f;
-
-        graphics::drawRect(
-            panelX + panelW * 0.5f,
-            panelY + panelH * 0.5f,
-            panelW,
-            panelH,
-            panel
-        );
-
-        graphics::Brush text;
-        text.fill_color[0] = 0.0f;
-        text.fill_color[1] = 0.0f;
-        text.fill_color[2] = 0.0f;
-
-        graphics::drawText(panelX + 90, panelY + 80, 36, "Press ENTER to start", text);
-
-        return;
+    int slot = gap / grid;
+    if (slot >= 64) return false;
+
+    members = taken | (1ull << slot);
+    stride = grid;
+    return true;
+}
+
+UnitHandle GlobalState::spawnUnit(int fromId, int toId, Owner owner)
+{
+    return spawnUnit(rules, fromId, toId, owner);
+}
+
+template <class R>
+UnitHandle GlobalState::spawnUnit(const R& r, int fromId, int toId, Owner owner)
+{
+    float speed = r.unitSpeed;
+    int steps = travelFor(speed);
+    sent.push_back({ fromId, toId, owner, UnitHandle(), false });
+
+    uint64_t key = 0;
+    if (r.unitStreams && steps > 0) {
+        key = ((uint64_t)(uint32_t)fromId << 32) | (uint32_t)toId;
+        auto it = streamTails.find(key);
+        int i = it != streamTails.end() ? units.indexOf(it->second) : -1;
+
+        // same owner and speed: the unit takes a slot in the run, which
+        // changes nothing else, since the head still lands first
+        if (i >= 0 && units.owner[i] == owner && units.speed[i] == speed &&
+            joinRun(units.members[i], units.stride[i], tick - units.depart[i])) {
+            sent.back().unit = it->second;
+            sent.back().joined = true;
+            return it->second;
+        }
     }
 
-    if (gameOver) {
-        float panelX = 350.0f;
-        float panelY = 220.0f;
-        float panelW = 500.0f;
-        float panelH = 180.0f;
-
-        graphics::Brush panel;
-        panel.fill_color[0] = 1.0f;
-        panel.fill_color[1] = 1.0f;
-        panel.fill_color[2] = 1.0f;
-        panel.fill_opacity = 1.0f;
-        panel.outline_opacity = 1.0f;
-        panel.outline_color[0] = 0.0f;
-        panel.outline_color[1] = 0.0f;
-        panel.outline_color[2] = 0.0f;
-
-        graphics::drawRect(
-            panelX + panelW * 0.5f,
-            panelY + panelH * 0.5f,
-            panelW,
-            panelH,
-            panel
-        );
-
-        graphics::Brush text;
-        if (winner == Owner::Player) {
-            text.fill_color[0] = 0.2f;
-            text.fill_color[1] = 0.5f;
-            text.fill_color[2] = 1.0f;
-            graphics::drawText(panelX + 120, panelY + 80, 48, "BLUE WON", text);
+    // a unit too slow to ever land just stays on the road
+    int landsOn = steps > 0 ? tick + steps - 1 : INT32_MAX;
+    UnitHandle h = units.spawn(fromId, toId, owner, speed, tick, landsOn);
+    if (steps > 0) arrivalWheel.schedule(h, landsOn, tick);
+    if (r.unitStreams && steps > 0) streamTails[key] = h;
+    sent.back().unit = h;
+    return h;
+}
+
+void GlobalState::collectArrivals()
+{
+    landing.clear();
+    arrivalWheel.take(tick, landing);
+
+    arrivals.clear();
+    for (UnitHandle h : landing)
+        arrivals.push_back((uint32_t)units.indexOf(h));
+    std::sort(arrivals.begin(), arrivals.end());
+}
+
+void GlobalState::retireArrivals()
+{
+    exhausted.clear();
+    for (uint32_t i : arrivals) {
+        uint64_t rest = units.members[i] >> 1;
+        if (rest) {
+            // the next unit becomes the head
+            int shift = __builtin_ctzll(rest);
+            units.members[i] = rest >> shift;
+            units.depart[i] += (shift + 1) * units.stride[i];
+            units.arrive[i] += (shift + 1) * units.stride[i];
+            arrivalWheel.schedule(units.handleAt(i), units.arrive[i], tick);
         } else {
-            text.fill_color[0] = 1.0f;
-            text.fill_color[1] = 0.3f;
-            text.fill_color[2] = 0.3f;
-            graphics::drawText(panelX + 140, panelY + 80, 48, "RED WON", text);
+            exhausted.push_back(i);
         }
+    }
+    units.removeSorted(exhausted);
+}
+
+size_t GlobalState::unitsInFlight() const
+{
+    size_t total = 0;
+    for (uint64_t s : units.members)
+        total += (size_t)__builtin_popcountll(s);
+    return total;
+}
+
+// units that landed this tick reinforce or attack their destination
+void GlobalState::resolveArrivals()
+{
+    // nothing below reads supplied, so a side that lost a supplied node is
+    // rebuilt once after the loop rather than per capture
+    bool stale[2] = { false, false };
+
+    for (uint32_t i : arrivals) {
+        Node* dest = &nodes[units.to[i]];
+        Owner owner = units.owner[i];
+
+        if (dest->owner == owner) {
+            if (dest->unitCount < dest->capacity)
+                dest->unitCount++;
+        } else {
+            dest->unitCount--;
+            if (dest->unitCount <= 0) {
+                Owner previous = dest->owner;
+                dest->owner = owner;
+                dest->unitCount = 1;
+                roundRobin[dest->id] = 0;
+
+                // losing a node can only cut off the loser's nodes behind
+                // it if it was supplied; the winner grows from it when it
+                // touches its supplied nodes
+                if (supplied[dest->id]) stale[(int)previous] = true;
+                supplied[dest->id] = 0;
+                if (!stale[(int)owner]) {
+                    for (int id : dest->edges) {
+                        if (nodes[id].owner == owner && supplied[id]) {
+                            spreadSupply(dest->id, owner);
+                            break;
+                        }
+                    }
+                }
 
-        text.fill_color[0] = 0.0f;
-        text.fill_color[1] = 0.0f;
-        text.fill_color[2] = 0.0f;
-        graphics::drawText(panelX + 140, panelY + 130, 24, "Press ESC to quit", text);
+                // direction and same-owner tests flip for dest and its
+                // neighbours
+                rebuildAdjacency(*dest);
+                for (int id : dest->edges)
+                    rebuildAdjacency(nodes[id]);
+
+                if (dest->id == playerBase || dest->id == enemyBase) {
+                    gameOver = true;
+                    winner = owner;
+                }
+            }
+        }
     }
+
+    for (Owner side : { Owner::Player, Owner::Enemy })
+        if (stale[(int)side]) rebuildSupply(side);
+
+    retireArrivals();
 }
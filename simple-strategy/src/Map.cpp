@@ -0,0 +1,454 @@
+#include "Map.h"
+#include "Node.h"
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static constexpr float WINDOW_W = 1200.0f;
+static constexpr int DEFAULT_CAPACITY = 50;
+
+MapView MapData::view() const
+{
+    MapView v;
+    v.nodes = nodes.data();
+    v.nodeCount = (uint32_t)nodes.size();
+    v.edges = edges.data();
+    v.edgeCount = (uint32_t)edges.size();
+    v.playerBase = playerBase;
+    v.enemyBase = enemyBase;
+    return v;
+}
+
+MapData defaultMap()
+{
+    MapData map;
+
+    float startX = 250.0f;
+    float gapY   = 100.0f;
+    float gapX   = 120.0f;
+
+    const int LAYERS = 3;
+
+    for (int side = 0; side < 2; ++side) {
+        Owner owner = side == 0 ? Owner::Player : Owner::Enemy;
+
+        for (int layer = 0; layer < LAYERS; ++layer) {
+            for (int i = 0; i <= layer; ++i) {
+                // Blue on the left, red mirrored on the right
+                float x = startX + layer * gapX;
+                if (owner == Owner::Enemy) x = WINDOW_W - x;
+
+                if (layer == 0 && i == 0) {
+                    if (owner == Owner::Player) map.playerBase = (int)map.nodes.size();
+                    else                        map.enemyBase = (int)map.nodes.size();
+                }
+
+                map.nodes.push_back({ x, 200.0f + i * gapY, layer, (int32_t)owner,
+                                      DEFAULT_CAPACITY, 0 });
+            }
+        }
+    }
+
+    return map;
+}
+
+MapData generateMap(int layers, int width, uint32_t seed)
+{
+    MapData map;
+    if (layers < 2) layers = 2;
+    if (width < 1) width = 1;
+
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> jitter(-15.0f, 15.0f);
+    std::uniform_int_distribution<int> units(0, 10);
+
+    const float gapX = 120.0f;
+    const float gapY = 100.0f;
+    const float margin = 100.0f;
+    layers = std::min(layers, (int)((MAP_EXTENT - 2.0f * margin) / (2.0f * gapX)));
+    width = std::min(width, (int)((MAP_EXTENT - 2.0f * margin) / gapY) - 1);
+    const float worldW = 2.0f * margin + (2 * layers - 1) * gapX;
+
+    // first node id of each layer, per side; layer 0 is the lone base
+    std::vector<int> first[2];
+
+    for (int side = 0; side < 2; ++side) {
+        Owner owner = side == 0 ? Owner::Player : Owner::Enemy;
+
+        for (int layer = 0; layer < layers; ++layer) {
+            first[side].push_back((int)map.nodes.size());
+            int count = layer == 0 ? 1 : width;
+
+            for (int i = 0; i < count; ++i) {
+                float x = margin + layer * gapX + jitter(rng);
+                if (owner == Owner::Enemy) x = worldW - x;
+                float y = margin + (i + 0.5f * (width - count)) * gapY + jitter(rng);
+
+                int start = layer == 0 ? 10 : units(rng);
+                map.nodes.push_back({ x, y, layer, (int32_t)owner, DEFAULT_CAPACITY, start });
+            }
+        }
+    }
+
+    map.playerBase = first[0][0];
+    map.enemyBase = first[1][0];
+
+    std::uniform_int_distribution<int> coin(0, 1);
+
+    for (int side = 0; side < 2; ++side) {
+        for (int layer = 0; layer + 1 < layers; ++layer) {
+            int count = layer == 0 ? 1 : width;
+            for (int i = 0; i < count; ++i) {
+                int a = first[side][layer] + i;
+                // the base fans out to the whole first layer
+                if (layer == 0) {
+                    for (int j = 0; j < width; ++j)
+                        map.edges.push_back({ a, first[side][1] + j });
+                    continue;
+                }
+                map.edges.push_back({ a, first[side][layer + 1] + i });
+                if (i + 1 < width && coin(rng))
+                    map.edges.push_back({ a, first[side][layer + 1] + i + 1 });
+            }
+        }
+    }
+
+    // front lines meet in the middle
+    for (int i = 0; i < width; ++i)
+        map.edges.push_back({ first[0][layers - 1] + i, first[1][layers - 1] + i });
+
+    return map;
+}
+
+bool validateMap(const MapView& map, std::string& error)
+{
+    for (uint32_t i = 0; i < map.nodeCount; ++i) {
+        const MapNode& n = map.nodes[i];
+        // also catches NaN, which fails every comparison
+        if (!(std::fabs(n.x) <= MAP_EXTENT) || !(std::fabs(n.y) <= MAP_EXTENT)) {
+            error = "node " + std::to_string(i) + ": coordinates outside the world";
+            return false;
+        }
+        if (n.owner != (int32_t)Owner::Player && n.owner != (int32_t)Owner::Enemy) {
+            error = "node " + std::to_string(i) + ": bad owner";
+            return false;
+        }
+        if (n.capacity <= 0 || n.unitCount < 0 || n.unitCount > n.capacity) {
+            error = "node " + std::to_string(i) + ": bad capacity or unit count";
+            return false;
+        }
+    }
+
+    for (uint32_t i = 0; i < map.edgeCount; ++i) {
+        const MapEdge& e = map.edges[i];
+        if (e.a < 0 || e.b < 0 || (uint32_t)e.a >= map.nodeCount ||
+            (uint32_t)e.b >= map.nodeCount || e.a == e.b)
+        {
+            error = "edge " + std::to_string(i) + ": bad node id";
+            return false;
+        }
+    }
+
+    if (map.playerBase < 0 || (uint32_t)map.playerBase >= map.nodeCount ||
+        map.enemyBase < 0 || (uint32_t)map.enemyBase >= map.nodeCount)
+    {
+        error = "map needs a base for each side";
+        return false;
+    }
+    if (map.playerBase == map.enemyBase ||
+        map.nodes[map.playerBase].owner != (int32_t)Owner::Player ||
+        map.nodes[map.enemyBase].owner != (int32_t)Owner::Enemy)
+    {
+        error = "each base must be a separate node owned by its side";
+        return false;
+    }
+
+    return true;
+}
+
+// ---- text ----
+
+static bool readWholeFile(const std::string& path, std::string& out, std::string& error)
+{
+    FILE* f = std::fopen(path.c_str(), "rb");
+    if (!f) {
+        error = path + ": " + std::strerror(errno);
+        return false;
+    }
+
+    std::fseek(f, 0, SEEK_END);
+    long len = std::ftell(f);
+    std::fseek(f, 0, SEEK_SET);
+
+    out.resize(len > 0 ? (size_t)len : 0);
+    size_t got = out.empty() ? 0 : std::fread(&out[0], 1, out.size(), f);
+    std::fclose(f);
+
+    if (got != out.size()) {
+        error = path + ": short read";
+        return false;
+    }
+    return true;
+}
+
+static bool parseOwner(const char* word, size_t len, int32_t& owner)
+{
+    if (len == 6 && std::strncmp(word, "player", 6) == 0) { owner = (int32_t)Owner::Player; return true; }
+    if (len == 5 && std::strncmp(word, "enemy", 5) == 0)  { owner = (int32_t)Owner::Enemy;  return true; }
+    return false;
+}
+
+bool loadMapText(const std::string& path, MapData& out, std::string& error)
+{
+    std::string text;
+    if (!readWholeFile(path, text, error)) return false;
+
+    out = MapData();
+
+    // single forward pass; strtol/strtof stop at the end of each field
+    const char* p = text.c_str();
+    int line = 0;
+
+    while (*p) {
+        line++;
+        const char* eol = std::strchr(p, '\n');
+        if (!eol) eol = p + std::strlen(p);
+
+        while (p < eol && (*p == ' ' || *p == '\t' || *p == '\r')) p++;
+        if (p == eol || *p == '#') {
+            p = *eol ? eol + 1 : eol;
+            continue;
+        }
+
+        const char* word = p;
+        while (p < eol && *p != ' ' && *p != '\t') p++;
+        size_t wordLen = (size_t)(p - word);
+
+        auto fail = [&](const char* what) {
+            error = path + ":" + std::to_string(line) + ": " + what;
+            return false;
+        };
+
+        auto skipBlank = [&]() {
+            while (p < eol && (*p == ' ' || *p == '\t' || *p == '\r')) p++;
+        };
+
+        auto readInt = [&](long& v) {
+            skipBlank();
+            if (p >= eol) return false;
+            char* end;
+            v = std::strtol(p, &end, 10);
+            if (end == p || end > eol) return false;
+            p = end;
+            return true;
+        };
+
+        auto readFloat = [&](float& v) {
+            skipBlank();
+            if (p >= eol) return false;
+            char* end;
+            v = std::strtof(p, &end);
+            if (end == p || end > eol) return false;
+            p = end;
+            return true;
+        };
+
+        auto readOwner = [&](int32_t& owner) {
+            skipBlank();
+            const char* w = p;
+            while (p < eol && *p != ' ' && *p != '\t' && *p != '\r') p++;
+            return parseOwner(w, (size_t)(p - w), owner);
+        };
+
+        if (wordLen == 4 && std::strncmp(word, "node", 4) == 0) {
+            MapNode n = { 0.0f, 0.0f, 0, 0, DEFAULT_CAPACITY, 0 };
+            long layer;
+            if (!readFloat(n.x) || !readFloat(n.y) || !readInt(layer) || !readOwner(n.owner))
+                return fail("expected: node <x> <y> <layer> <player|enemy> [capacity] [units]");
+            n.layer = (int32_t)layer;
+
+            long v;
+            if (readInt(v)) n.capacity = (int32_t)v;
+            if (readInt(v)) n.unitCount = (int32_t)v;
+            out.nodes.push_back(n);
+        } else if (wordLen == 4 && std::strncmp(word, "edge", 4) == 0) {
+            long a, b;
+            if (!readInt(a) || !readInt(b))
+                return fail("expected: edge <a> <b>");
+            out.edges.push_back({ (int32_t)a, (int32_t)b });
+        } else if (wordLen == 4 && std::strncmp(word, "base", 4) == 0) {
+            int32_t owner;
+            long id;
+            if (!readOwner(owner) || !readInt(id))
+                return fail("expected: base <player|enemy> <node>");
+            if (owner == (int32_t)Owner::Player) out.playerBase = (int)id;
+            else                                 out.enemyBase = (int)id;
+        } else {
+            return fail("unknown record");
+        }
+
+        p = *eol ? eol + 1 : eol;
+    }
+
+    for (size_t i = 0; i < out.nodes.size(); ++i) {
+        const MapNode& n = out.nodes[i];
+        if (n.layer != 0) continue;
+        if (n.owner == (int32_t)Owner::Player && out.playerBase < 0) out.playerBase = (int)i;
+        if (n.owner == (int32_t)Owner::Enemy && out.enemyBase < 0)   out.enemyBase = (int)i;
+    }
+
+    std::string why;
+    if (!validateMap(out.view(), why)) {
+        error = path + ": " + why;
+        return false;
+    }
+    return true;
+}
+
+bool saveMapText(const std::string& path, const MapView& map, std::string& error)
+{
+    FILE* f = std::fopen(path.c_str(), "w");
+    if (!f) {
+        error = path + ": " + std::strerror(errno);
+        return false;
+    }
+
+    for (uint32_t i = 0; i < map.nodeCount; ++i) {
+        const MapNode& n = map.nodes[i];
+        std::fprintf(f, "node %g %g %d %s %d %d\n", n.x, n.y, n.layer,
+                     n.owner == (int32_t)Owner::Player ? "player" : "enemy",
+                     n.capacity, n.unitCount);
+    }
+    for (uint32_t i = 0; i < map.edgeCount; ++i)
+        std::fprintf(f, "edge %d %d\n", map.edges[i].a, map.edges[i].b);
+
+    std::fprintf(f, "base player %d\nbase enemy %d\n", map.playerBase, map.enemyBase);
+
+    if (std::fclose(f) != 0) {
+        error = path + ": write failed";
+        return false;
+    }
+    return true;
+}
+
+// ---- binary ----
+
+bool isBinaryMap(const std::string& path)
+{
+    FILE* f = std::fopen(path.c_str(), "rb");
+    if (!f) return false;
+
+    char magic[4] = {};
+    size_t got = std::fread(magic, 1, 4, f);
+    std::fclose(f);
+
+    return got == 4 && std::memcmp(magic, MAP_MAGIC, 4) == 0;
+}
+
+bool saveMapBinary(const std::string& path, const MapView& map, std::string& error)
+{
+    FILE* f = std::fopen(path.c_str(), "wb");
+    if (!f) {
+        error = path + ": " + std::strerror(errno);
+        return false;
+    }
+
+    MapHeader h;
+    std::memcpy(h.magic, MAP_MAGIC, 4);
+    h.version = MAP_VERSION;
+    h.nodeCount = map.nodeCount;
+    h.edgeCount = map.edgeCount;
+    h.playerBase = map.playerBase;
+    h.enemyBase = map.enemyBase;
+
+    bool ok = std::fwrite(&h, sizeof(h), 1, f) == 1;
+    if (ok && map.nodeCount)
+        ok = std::fwrite(map.nodes, sizeof(MapNode), map.nodeCount, f) == map.nodeCount;
+    if (ok && map.edgeCount)
+        ok = std::fwrite(map.edges, sizeof(MapEdge), map.edgeCount, f) == map.edgeCount;
+
+    if (std::fclose(f) != 0) ok = false;
+    if (!ok) error = path + ": write failed";
+    return ok;
+}
+
+MapFile::~MapFile()
+{
+    close();
+}
+
+void MapFile::close()
+{
+    if (data) munmap(data, size);
+    data = nullptr;
+    size = 0;
+    mapView = MapView();
+}
+
+bool MapFile::open(const std::string& path, std::string& error)
+{
+    close();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        error = path + ": " + std::strerror(errno);
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(MapHeader)) {
+        ::close(fd);
+        error = path + ": not a binary map";
+        return false;
+    }
+
+    size = (size_t)st.st_size;
+    data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+
+    if (data == MAP_FAILED) {
+        data = nullptr;
+        size = 0;
+        error = path + ": " + std::strerror(errno);
+        return false;
+    }
+
+    const MapHeader* h = (const MapHeader*)data;
+    if (std::memcmp(h->magic, MAP_MAGIC, 4) != 0 || h->version != MAP_VERSION) {
+        close();
+        error = path + ": not a binary map (or wrong version)";
+        return false;
+    }
+
+    size_t need = sizeof(MapHeader) + (size_t)h->nodeCount * sizeof(MapNode) +
+                  (size_t)h->edgeCount * sizeof(MapEdge);
+    if (size < need) {
+        close();
+        error = path + ": truncated";
+        return false;
+    }
+
+    const char* base = (const char*)data + sizeof(MapHeader);
+    mapView.nodes = (const MapNode*)base;
+    mapView.nodeCount = h->nodeCount;
+    mapView.edges = (const MapEdge*)(base + (size_t)h->nodeCount * sizeof(MapNode));
+    mapView.edgeCount = h->edgeCount;
+    mapView.playerBase = h->playerBase;
+    mapView.enemyBase = h->enemyBase;
+
+    std::string why;
+    if (!validateMap(mapView, why)) {
+        close();
+        error = path + ": " + why;
+        return false;
+    }
+    return true;
+}
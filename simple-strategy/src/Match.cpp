@@ -0,0 +1,24 @@
+#include "Match.h"
+#include "GlobalState.h"
+
+MatchResult runMatch(const MapView& map, const Rules& rules, int maxTicks)
+{
+    GlobalState game;
+    game.rules = rules;
+    game.load(map);
+    game.submit({ CommandType::Start });
+
+    while (game.tick < maxTicks && !game.gameOver)
+        game.step();
+
+    MatchResult r;
+    r.finished = game.gameOver;
+    r.winner = game.winner;
+    r.ticks = game.tick;
+
+    for (const Node& n : game.nodes) {
+        r.nodes[(int)n.owner]++;
+        r.units[(int)n.owner] += n.unitCount;
+    }
+    return r;
+}
@@ -0,0 +1,253 @@
+#include "MctsBot.h"
+#include "EnemyAI.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+static Owner opponentOf(Owner side)
+{
+    return side == Owner::Player ? Owner::Enemy : Owner::Player;
+}
+
+MctsBot::MctsBot(Owner side, WorkStealingPool& pool, const MctsConfig& config)
+    : config(config), me(side), pool(pool)
+{
+}
+
+bool MctsBot::think(const GlobalState& game, Command& out)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    int treeCount = config.trees > 0 ? config.trees : pool.threadCount();
+    trees.resize(treeCount);
+    scratch.resize(pool.threadCount());
+    thinkCount++;
+
+    pool.run((size_t)treeCount, [&](size_t i, int worker) {
+        Tree& tree = trees[i];
+        tree.nodes.clear();
+        tree.nodes.push_back(TreeNode());
+        tree.rng.seed(config.seed + thinkCount * 7919u + (uint32_t)i * 104729u);
+        tree.rollouts = 0;
+        tree.ticks = 0;
+
+        int share = config.iterations / treeCount + ((int)i < config.iterations % treeCount ? 1 : 0);
+        search(tree, game, scratch[worker], share);
+    });
+
+    // every tree expands the root from the same state, so root children
+    // line up one to one
+    std::vector<int> visits;
+    const Tree* first = nullptr;
+    for (const Tree& tree : trees) {
+        const TreeNode& root = tree.nodes[0];
+        if (!root.expanded) continue;
+        if (!first) {
+            first = &tree;
+            visits.assign(root.childCount, 0);
+        }
+        for (int c = 0; c < root.childCount && c < (int)visits.size(); ++c)
+            visits[c] += tree.nodes[root.firstChild + c].visits;
+    }
+
+    last = MctsStats();
+    for (const Tree& tree : trees) {
+        last.rollouts += tree.rollouts;
+        last.ticks += tree.ticks;
+    }
+    last.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    total.rollouts += last.rollouts;
+    total.ticks += last.ticks;
+    total.seconds += last.seconds;
+
+    if (!first || visits.empty()) return false;
+
+    int best = (int)(std::max_element(visits.begin(), visits.end()) - visits.begin());
+    const Move& m = first->nodes[first->nodes[0].firstChild + best].move;
+    if (m.from < 0) return false;
+
+    out = { CommandType::Connect, m.from, m.to };
+    return true;
+}
+
+void MctsBot::search(Tree& tree, const GlobalState& root, GlobalState& state, int iterations)
+{
+    for (int it = 0; it < iterations; ++it) {
+        state.cloneFrom(root);
+        int node = 0;
+
+        // selection: descend by UCT through fully expanded nodes
+        while (tree.nodes[node].expanded && tree.nodes[node].childCount > 0 && !state.gameOver) {
+            const TreeNode& parent = tree.nodes[node];
+            double logN = std::log((double)parent.visits + 1.0);
+            int best = -1;
+            double bestUct = -1.0;
+
+            for (int c = 0; c < parent.childCount; ++c) {
+                const TreeNode& child = tree.nodes[parent.firstChild + c];
+                if (child.visits == 0) {
+                    best = parent.firstChild + c;
+                    break;
+                }
+                double uct = child.value / child.visits +
+                             config.exploration * std::sqrt(logN / child.visits);
+                if (uct > bestUct) {
+                    bestUct = uct;
+                    best = parent.firstChild + c;
+                }
+            }
+
+            node = best;
+            tree.ticks += play(state, tree.nodes[node].move, tree.rng, config.decisionTicks);
+            if (tree.nodes[node].visits == 0) break;
+        }
+
+        // expansion: a visited leaf gets its children and we step into one
+        if (!tree.nodes[node].expanded && !state.gameOver &&
+            (node == 0 || tree.nodes[node].visits > 0)) {
+            expand(tree, node, state);
+            const TreeNode& leaf = tree.nodes[node];
+            if (leaf.childCount > 0) {
+                std::uniform_int_distribution<int> pick(0, leaf.childCount - 1);
+                node = leaf.firstChild + pick(tree.rng);
+                tree.ticks += play(state, tree.nodes[node].move, tree.rng, config.decisionTicks);
+            }
+        }
+
+        // rollout: random roads for both sides
+        for (int t = 0; t < config.rolloutTicks && !state.gameOver; t += config.decisionTicks) {
+            Move m;
+            Command c;
+            if (tree.rng() % 2 && randomRoad(state, me, tree.rng, c)) {
+                m.from = c.from;
+                m.to = c.to;
+            }
+            tree.ticks += play(state, m, tree.rng, config.decisionTicks);
+        }
+
+        double result = evaluate(state);
+        tree.rollouts++;
+
+        for (int n = node; n >= 0; n = tree.nodes[n].parent) {
+            tree.nodes[n].visits++;
+            tree.nodes[n].value += result;
+        }
+    }
+}
+
+void MctsBot::expand(Tree& tree, int node, const GlobalState& state)
+{
+    std::vector<Move> moves;
+    listMoves(state, moves);
+    moves.push_back(Move()); // waiting is always an option
+
+    int first = (int)tree.nodes.size();
+    for (const Move& m : moves) {
+        TreeNode child;
+        child.move = m;
+        child.parent = node;
+        tree.nodes.push_back(child);
+    }
+
+    TreeNode& n = tree.nodes[node];
+    n.expanded = true;
+    n.firstChild = first;
+    n.childCount = (int)moves.size();
+}
+
+void MctsBot::listMoves(const GlobalState& state, std::vector<Move>& out) const
+{
+    struct Scored {
+        Move move;
+        float score;
+    };
+    std::vector<Scored> all;
+
+    float r = config.reach;
+    for (const Node& from : state.nodes) {
+        if (from.owner != me || !state.canSelect(&from)) continue;
+
+        state.grid.forEachInRect(state.nodes, from.x - r, from.y - r, from.x + r, from.y + r,
+            [&](int id) {
+                const Node& to = state.nodes[id];
+                if (!state.canCreateEdge(&from, &to, me)) return;
+                float s = scoreRoad(state, from, to, me);
+                if (s > 0.0f) all.push_back({ { from.id, id }, s });
+            });
+    }
+
+    // best first; ties by ids so every tree lists the same moves
+    size_t keep = std::min(all.size(), (size_t)std::max(config.maxActions, 0));
+    std::partial_sort(all.begin(), all.begin() + keep, all.end(), [](const Scored& a, const Scored& b) {
+        if (a.score != b.score) return a.score > b.score;
+        if (a.move.from != b.move.from) return a.move.from < b.move.from;
+        return a.move.to < b.move.to;
+    });
+
+    for (size_t i = 0; i < keep; ++i)
+        out.push_back(all[i].move);
+}
+
+bool MctsBot::randomRoad(const GlobalState& state, Owner who, std::mt19937& rng, Command& out) const
+{
+    // a few random tries instead of listing every road: rollouts need to
+    // be cheap more than they need to be good
+    std::uniform_int_distribution<int> pickNode(0, (int)state.nodes.size() - 1);
+    float r = config.reach;
+
+    for (int attempt = 0; attempt < 8; ++attempt) {
+        const Node& from = state.nodes[pickNode(rng)];
+        if (from.owner != who || !state.canSelect(&from)) continue;
+
+        int chosen = -1, seen = 0;
+        state.grid.forEachInRect(state.nodes, from.x - r, from.y - r, from.x + r, from.y + r,
+            [&](int id) {
+                if (!state.canCreateEdge(&from, &state.nodes[id], who)) return;
+                // reservoir sample over the valid targets
+                if (std::uniform_int_distribution<int>(0, seen++)(rng) == 0) chosen = id;
+            });
+
+        if (chosen >= 0) {
+            out = { CommandType::Connect, from.id, chosen };
+            return true;
+        }
+    }
+    return false;
+}
+
+long long MctsBot::play(GlobalState& state, const Move& ours, std::mt19937& rng, int ticks) const
+{
+    if (ours.from >= 0)
+        state.submit({ CommandType::Connect, ours.from, ours.to });
+
+    Command reply;
+    if (rng() % 2 && randomRoad(state, opponentOf(me), rng, reply))
+        state.submit(reply);
+
+    long long played = 0;
+    for (int t = 0; t < ticks && !state.gameOver; ++t) {
+        state.step();
+        played++;
+    }
+    return played;
+}
+
+double MctsBot::evaluate(const GlobalState& state) const
+{
+    if (state.gameOver) return state.winner == me ? 1.0 : 0.0;
+
+    // otherwise a share of the map: nodes held and units on them
+    int nodes[2] = { 0, 0 };
+    int units[2] = { 0, 0 };
+    for (const Node& n : state.nodes) {
+        nodes[(int)n.owner]++;
+        units[(int)n.owner] += n.unitCount;
+    }
+
+    int mine = (int)me, theirs = (int)opponentOf(me);
+    double nodeShare = (double)nodes[mine] / std::max(1, nodes[mine] + nodes[theirs]);
+    double unitShare = (double)units[mine] / std::max(1, units[mine] + units[theirs]);
+
+    // keep non-final results strictly between a loss and a win
+    return 0.1 + 0.8 * (0.5 * nodeShare + 0.5 * unitShare);
+}
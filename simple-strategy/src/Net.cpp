@@ -0,0 +1,150 @@
+#include "Net.h"
+#include <cerrno>
+#include <cstring>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+size_t beginFrame(std::vector<uint8_t>& out, MsgType type)
+{
+    size_t start = out.size();
+    out.resize(start + 4);
+    out.push_back((uint8_t)type);
+    return start;
+}
+
+void finishFrame(std::vector<uint8_t>& out, size_t start)
+{
+    uint32_t length = (uint32_t)(out.size() - start - 4);
+    for (int i = 0; i < 4; ++i)
+        out[start + i] = (uint8_t)(length >> (8 * i));
+}
+
+bool nextFrame(const std::vector<uint8_t>& buf, size_t& offset, MsgType& type,
+               const uint8_t*& payload, size_t& size, std::string& error)
+{
+    if (buf.size() - offset < 4) return false;
+
+    const uint8_t* p = buf.data() + offset;
+    uint32_t length = (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+    if (length == 0 || length > MAX_FRAME) {
+        error = "bad frame length";
+        return false;
+    }
+    if (buf.size() - offset - 4 < length) return false;
+
+    type = (MsgType)p[4];
+    payload = p + 5;
+    size = length - 1;
+    offset += 4 + length;
+    return true;
+}
+
+static bool setNonBlocking(int fd)
+{
+    int flags = fcntl(fd, F_GETFL, 0);
+    return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+int listenTcp(uint16_t port, std::string& error)
+{
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) {
+        error = std::string("socket: ") + std::strerror(errno);
+        return -1;
+    }
+
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(port);
+
+    if (bind(fd, (sockaddr*)&addr, sizeof(addr)) != 0 || listen(fd, 512) != 0 || !setNonBlocking(fd)) {
+        error = "port " + std::to_string(port) + ": " + std::strerror(errno);
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int connectTcp(const std::string& host, uint16_t port, std::string& error)
+{
+    addrinfo hints = {};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+
+    addrinfo* found = nullptr;
+    int rc = getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &found);
+    if (rc != 0) {
+        error = host + ": " + gai_strerror(rc);
+        return -1;
+    }
+
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0 || connect(fd, found->ai_addr, found->ai_addrlen) != 0) {
+        error = host + ":" + std::to_string(port) + ": " + std::strerror(errno);
+        if (fd >= 0) close(fd);
+        freeaddrinfo(found);
+        return -1;
+    }
+    freeaddrinfo(found);
+
+    // commands are tiny and latency-bound
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    if (!setNonBlocking(fd)) {
+        error = std::string("fcntl: ") + std::strerror(errno);
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+uint16_t localPort(int fd)
+{
+    sockaddr_in addr = {};
+    socklen_t len = sizeof(addr);
+    if (getsockname(fd, (sockaddr*)&addr, &len) != 0) return 0;
+    return ntohs(addr.sin_port);
+}
+
+bool readSome(int fd, std::vector<uint8_t>& in)
+{
+    uint8_t buf[16384];
+    for (;;) {
+        ssize_t got = recv(fd, buf, sizeof(buf), 0);
+        if (got > 0) {
+            in.insert(in.end(), buf, buf + got);
+            continue;
+        }
+        if (got == 0) return false;
+        if (errno == EINTR) continue;
+        return errno == EAGAIN || errno == EWOULDBLOCK;
+    }
+}
+
+bool writeSome(int fd, std::vector<uint8_t>& out)
+{
+    size_t sent = 0;
+    while (sent < out.size()) {
+        ssize_t n = send(fd, out.data() + sent, out.size() - sent, MSG_NOSIGNAL);
+        if (n > 0) {
+            sent += (size_t)n;
+            continue;
+        }
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        out.erase(out.begin(), out.begin() + sent);
+        return false;
+    }
+    out.erase(out.begin(), out.begin() + sent);
+    return true;
+}
@@ -0,0 +1,106 @@
+#include "Profiler.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+const char* phaseName(Phase phase)
+{
+    switch (phase) {
+    case Phase::Input:      return "input";
+    case Phase::AI:         return "ai";
+    case Phase::Update:     return "update";
+    case Phase::Commands:   return "commands";
+    case Phase::Production: return "production";
+    case Phase::Sending:    return "sending";
+    case Phase::Movement:   return "movement";
+    case Phase::Arrivals:   return "arrivals";
+    case Phase::Draw:       return "draw";
+    case Phase::DrawRoads:  return "draw roads";
+    case Phase::DrawNodes:  return "draw nodes";
+    case Phase::DrawUnits:  return "draw units";
+    case Phase::DrawUI:     return "draw ui";
+    case Phase::Count:      break;
+    }
+    return "?";
+}
+
+Profiler::Profiler(size_t traceCapacity)
+    : origin(Clock::now()), trace(traceCapacity)
+{
+}
+
+void Profiler::add(Phase phase, Clock::time_point start, Clock::time_point end)
+{
+    int64_t startNs = std::chrono::duration_cast<std::chrono::nanoseconds>(start - origin).count();
+    int64_t durationNs = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+
+    current[(int)phase] += durationNs * 1e-6;
+
+    if (trace.empty()) return;
+    trace[traceNext] = { startNs, durationNs, phase };
+    traceNext = (traceNext + 1) % trace.size();
+    if (traceSize < trace.size()) traceSize++;
+}
+
+void Profiler::endFrame()
+{
+    std::copy(current, current + PHASES, history[frameCount % HISTORY]);
+    std::fill(current, current + PHASES, 0.0);
+    frameCount++;
+}
+
+double Profiler::lastFrame(Phase phase) const
+{
+    if (frameCount == 0) return 0.0;
+    return history[(frameCount - 1) % HISTORY][(int)phase];
+}
+
+double Profiler::average(Phase phase) const
+{
+    int n = frames();
+    if (n == 0) return 0.0;
+
+    double sum = 0.0;
+    for (int i = 0; i < n; ++i) sum += history[i][(int)phase];
+    return sum / n;
+}
+
+double Profiler::peak(Phase phase) const
+{
+    double worst = 0.0;
+    for (int i = 0; i < frames(); ++i)
+        worst = std::max(worst, history[i][(int)phase]);
+    return worst;
+}
+
+bool Profiler::exportTrace(const std::string& path, std::string& error) const
+{
+    FILE* f = std::fopen(path.c_str(), "w");
+    if (!f) {
+        error = path + ": " + std::strerror(errno);
+        return false;
+    }
+
+    // complete ("X") events; timestamps and durations in microseconds
+    std::fprintf(f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    size_t first = (traceNext + trace.size() - traceSize) % (trace.empty() ? 1 : trace.size());
+    for (size_t k = 0; k < traceSize; ++k) {
+        const TraceEvent& e = trace[(first + k) % trace.size()];
+        std::fprintf(f, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%.3f,\"dur\":%.3f}\n",
+                     k ? "," : "", phaseName(e.phase), e.startNs * 1e-3, e.durationNs * 1e-3);
+    }
+    std::fprintf(f, "]}\n");
+
+    if (std::fclose(f) != 0) {
+        error = path + ": write failed";
+        return false;
+    }
+    return true;
+}
+
+void Profiler::clearTrace()
+{
+    traceNext = 0;
+    traceSize = 0;
+}
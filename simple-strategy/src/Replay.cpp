@@ -0,0 +1,304 @@
+#include "Replay.h"
+#include "Varint.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+static constexpr char REPLAY_MAGIC[4] = { 'S', 'S', 'R', 'P' };
+static constexpr uint32_t REPLAY_VERSION = 4; // 2: Rules::unitStreams, 3: rules field by field, 4: end tick
+
+// FNV-1a over the starting layout: owners, counts and roads. Positions are
+// left out so a map that went through the text format (rounded to a few
+// digits) still matches.
+static uint64_t layoutHash(const GlobalState& game)
+{
+    uint64_t h = 14695981039346656037ull;
+    auto mix = [&h](const void* data, size_t size) {
+        const uint8_t* p = (const uint8_t*)data;
+        for (size_t i = 0; i < size; ++i) {
+            h ^= p[i];
+            h *= 1099511628211ull;
+        }
+    };
+
+    for (const Node& n : game.nodes) {
+        mix(&n.layer, sizeof(n.layer));
+        mix(&n.owner, sizeof(n.owner));
+        mix(&n.capacity, sizeof(n.capacity));
+        mix(&n.unitCount, sizeof(n.unitCount));
+    }
+    for (const Road& r : game.roads)
+        mix(&r, sizeof(r));
+    mix(&game.playerBase, sizeof(game.playerBase));
+    mix(&game.enemyBase, sizeof(game.enemyBase));
+    return h;
+}
+
+// floats as their bits, little-endian, so files do not depend on the host
+static void putFloat(std::vector<uint8_t>& out, float f)
+{
+    uint32_t bits;
+    std::memcpy(&bits, &f, sizeof(bits));
+    for (int i = 0; i < 4; ++i)
+        out.push_back((uint8_t)(bits >> (8 * i)));
+}
+
+static bool getFloat(const uint8_t*& p, const uint8_t* end, float& f)
+{
+    if (end - p < 4) return false;
+    uint32_t bits = 0;
+    for (int i = 0; i < 4; ++i)
+        bits |= (uint32_t)p[i] << (8 * i);
+    std::memcpy(&f, &bits, sizeof(f));
+    p += 4;
+    return true;
+}
+
+void ReplayLog::begin(const GlobalState& game)
+{
+    rules = game.rules;
+    nodeCount = (uint32_t)game.nodes.size();
+    mapHash = layoutHash(game);
+    commands.clear();
+    endTick = 0;
+}
+
+void ReplayLog::finish(const GlobalState& game)
+{
+    endTick = game.tick;
+}
+
+bool ReplayLog::fits(const GlobalState& game) const
+{
+    return nodeCount == game.nodes.size() && mapHash == layoutHash(game);
+}
+
+void ReplayLog::record(int tick, const Command& cmd)
+{
+    commands.push_back({ tick, cmd });
+}
+
+void ReplayLog::encode(std::vector<uint8_t>& out) const
+{
+    out.clear();
+    for (char c : REPLAY_MAGIC)
+        out.push_back((uint8_t)c);
+    putVarint(out, REPLAY_VERSION);
+
+    putFloat(out, rules.sendInterval);
+    putFloat(out, rules.produceInterval);
+    putFloat(out, rules.unitSpeed);
+    putSignedVarint(out, rules.redistributeMargin);
+    out.push_back(rules.unitStreams ? 1 : 0);
+
+    putVarint(out, nodeCount);
+    putVarint(out, mapHash);
+    putVarint(out, commands.size());
+
+    int prevTick = 0;
+    for (const TimedCommand& tc : commands) {
+        putVarint(out, (uint64_t)(tc.tick - prevTick));
+        prevTick = tc.tick;
+
+        out.push_back((uint8_t)tc.cmd.type);
+        if (tc.cmd.type == CommandType::Connect) {
+            putVarint(out, (uint64_t)tc.cmd.from);
+            putVarint(out, (uint64_t)tc.cmd.to);
+        }
+    }
+    putVarint(out, (uint64_t)std::max(endTick - prevTick, 0));
+}
+
+bool ReplayLog::decode(const uint8_t* data, size_t size, std::string& error)
+{
+    const uint8_t* p = data;
+    const uint8_t* end = data + size;
+    uint64_t v, count;
+
+    if (size < 4 || std::memcmp(p, REPLAY_MAGIC, 4) != 0) {
+        error = "not a replay";
+        return false;
+    }
+    p += 4;
+
+    if (!getVarint(p, end, v) || v != REPLAY_VERSION) {
+        error = "unsupported replay version";
+        return false;
+    }
+
+    int64_t margin;
+    if (!getFloat(p, end, rules.sendInterval) || !getFloat(p, end, rules.produceInterval) ||
+        !getFloat(p, end, rules.unitSpeed) || !getSignedVarint(p, end, margin) || p >= end) {
+        error = "truncated replay";
+        return false;
+    }
+    uint8_t streams = *p++;
+    if (margin < INT32_MIN || margin > INT32_MAX || streams > 1) {
+        error = "bad rules in replay";
+        return false;
+    }
+    rules.redistributeMargin = (int)margin;
+    rules.unitStreams = streams != 0;
+    if (!rules.valid()) {
+        error = "bad rules in replay";
+        return false;
+    }
+
+    if (!getVarint(p, end, v)) { error = "truncated replay"; return false; }
+    nodeCount = (uint32_t)v;
+    if (!getVarint(p, end, mapHash) || !getVarint(p, end, count)) {
+        error = "truncated replay";
+        return false;
+    }
+
+    commands.clear();
+    int tick = 0;
+    for (uint64_t i = 0; i < count; ++i) {
+        if (!getVarint(p, end, v) || p >= end) {
+            error = "truncated replay";
+            return false;
+        }
+        if (v > (uint64_t)(INT32_MAX - tick)) {
+            error = "bad tick in replay";
+            return false;
+        }
+        tick += (int)v;
+
+        TimedCommand tc;
+        tc.tick = tick;
+        tc.cmd.type = (CommandType)*p++;
+
+        if (tc.cmd.type == CommandType::Connect) {
+            uint64_t from, to;
+            if (!getVarint(p, end, from) || !getVarint(p, end, to)) {
+                error = "truncated replay";
+                return false;
+            }
+            if (from >= nodeCount || to >= nodeCount) {
+                error = "bad node id in replay";
+                return false;
+            }
+            tc.cmd.from = (int)from;
+            tc.cmd.to = (int)to;
+        } else if (tc.cmd.type != CommandType::Start) {
+            error = "unknown command in replay";
+            return false;
+        }
+
+        commands.push_back(tc);
+    }
+
+    if (!getVarint(p, end, v)) {
+        error = "truncated replay";
+        return false;
+    }
+    if (v > (uint64_t)(INT32_MAX - tick)) {
+        error = "bad end tick in replay";
+        return false;
+    }
+    endTick = tick + (int)v;
+    return true;
+}
+
+bool ReplayLog::save(const std::string& path, std::string& error) const
+{
+    std::vector<uint8_t> bytes;
+    encode(bytes);
+
+    FILE* f = std::fopen(path.c_str(), "wb");
+    if (!f) {
+        error = path + ": " + std::strerror(errno);
+        return false;
+    }
+
+    bool ok = std::fwrite(bytes.data(), 1, bytes.size(), f) == bytes.size();
+    if (std::fclose(f) != 0) ok = false;
+    if (!ok) error = path + ": write failed";
+    return ok;
+}
+
+bool ReplayLog::load(const std::string& path, std::string& error)
+{
+    FILE* f = std::fopen(path.c_str(), "rb");
+    if (!f) {
+        error = path + ": " + std::strerror(errno);
+        return false;
+    }
+
+    std::vector<uint8_t> bytes;
+    uint8_t buf[4096];
+    size_t got;
+    while ((got = std::fread(buf, 1, sizeof(buf), f)) > 0)
+        bytes.insert(bytes.end(), buf, buf + got);
+    std::fclose(f);
+
+    if (!decode(bytes.data(), bytes.size(), error)) {
+        error = path + ": " + error;
+        return false;
+    }
+    return true;
+}
+
+ReplayPlayer::ReplayPlayer(const MapView& map, const ReplayLog& log, int snapshotInterval)
+    : log(log), snapshotInterval(snapshotInterval > 0 ? snapshotInterval : TICK_RATE * 60)
+{
+    game.rules = log.rules;
+    game.load(map);
+
+    snapshots.push_back({ 0, 0, {} });
+    game.snapshot(snapshots.back().bytes);
+}
+
+int ReplayPlayer::lastCommandTick() const
+{
+    return log.commands.empty() ? 0 : log.commands.back().tick;
+}
+
+void ReplayPlayer::advance()
+{
+    // commands were recorded with the tick they were applied at, which is
+    // the tick the state is at when the step that applies them starts
+    while (next < log.commands.size() && log.commands[next].tick == game.tick)
+        game.submit(log.commands[next++].cmd);
+
+    game.step();
+
+    if (game.tick % snapshotInterval == 0 && game.tick > snapshots.back().tick) {
+        snapshots.push_back({ game.tick, next, {} });
+        game.snapshot(snapshots.back().bytes);
+    }
+}
+
+void ReplayPlayer::runTo(int target)
+{
+    while (game.tick < target && !game.gameOver) {
+        int before = game.tick;
+        advance();
+
+        // a log without a Start never gets the clock moving
+        if (game.tick == before && !game.gameStarted && next >= log.commands.size())
+            break;
+    }
+}
+
+void ReplayPlayer::seek(int target)
+{
+    // nearest snapshot at or before target; only worth restoring if it is
+    // ahead of where we are, or we have to go backwards
+    const Snapshot* best = &snapshots[0];
+    for (const Snapshot& s : snapshots)
+        if (s.tick <= target) best = &s;
+
+    if (target < game.tick || best->tick > game.tick) {
+        // written by this player, so it always parses
+        SnapshotView view;
+        std::string error;
+        parseSnapshot(best->bytes.data(), best->bytes.size(), view, error);
+
+        game.restore(view);
+        next = best->next;
+    }
+
+    runTo(target);
+}
@@ -0,0 +1,160 @@
+#include "RoadBatch.h"
+#include <GL/glew.h>
+#include <cstdio>
+
+// world -> canvas as in Camera::toCanvasX/Y, then canvas -> clip space
+static const char* VERTEX_SHADER = R"(#version 330 core
+layout(location = 0) in vec2 world;
+uniform vec2 center;
+uniform float zoom;
+uniform vec2 canvas;
+void main()
+{
+    vec2 p = (world - center) * zoom + canvas * 0.5;
+    gl_Position = vec4(p.x / canvas.x * 2.0 - 1.0, 1.0 - p.y / canvas.y * 2.0, 0.0, 1.0);
+}
+)";
+
+static const char* FRAGMENT_SHADER = R"(#version 330 core
+uniform vec3 color;
+out vec4 fragColor;
+void main()
+{
+    fragColor = vec4(color, 1.0);
+}
+)";
+
+static GLuint compileShader(GLenum type, const char* source)
+{
+    GLuint shader = glCreateShader(type);
+    glShaderSource(shader, 1, &source, nullptr);
+    glCompileShader(shader);
+
+    GLint ok = GL_FALSE;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &ok);
+    if (!ok) {
+        char log[512];
+        glGetShaderInfoLog(shader, sizeof(log), nullptr, log);
+        std::fprintf(stderr, "RoadBatch: shader: %s\n", log);
+        glDeleteShader(shader);
+        return 0;
+    }
+    return shader;
+}
+
+bool RoadBatch::init()
+{
+    if (ready()) return true;
+
+    glewExperimental = GL_TRUE;
+    if (glewInit() != GLEW_OK || !GLEW_VERSION_3_3) return false;
+
+    GLuint vs = compileShader(GL_VERTEX_SHADER, VERTEX_SHADER);
+    GLuint fs = compileShader(GL_FRAGMENT_SHADER, FRAGMENT_SHADER);
+    if (!vs || !fs) {
+        if (vs) glDeleteShader(vs);
+        if (fs) glDeleteShader(fs);
+        return false;
+    }
+
+    program = glCreateProgram();
+    glAttachShader(program, vs);
+    glAttachShader(program, fs);
+    glLinkProgram(program);
+    glDeleteShader(vs);
+    glDeleteShader(fs);
+
+    GLint ok = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &ok);
+    if (!ok) {
+        glDeleteProgram(program);
+        program = 0;
+        return false;
+    }
+
+    uCenter = glGetUniformLocation(program, "center");
+    uZoom = glGetUniformLocation(program, "zoom");
+    uCanvas = glGetUniformLocation(program, "canvas");
+    uColor = glGetUniformLocation(program, "color");
+
+    GLint prevVao = 0, prevBuffer = 0;
+    glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &prevVao);
+    glGetIntegerv(GL_ARRAY_BUFFER_BINDING, &prevBuffer);
+
+    glGenVertexArrays(1, &vao);
+    glBindVertexArray(vao);
+
+    glGenBuffers(1, &vertexBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, nullptr);
+
+    // the element binding is part of the vertex array
+    glGenBuffers(1, &indexBuffer);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+
+    glBindVertexArray((GLuint)prevVao);
+    glBindBuffer(GL_ARRAY_BUFFER, (GLuint)prevBuffer);
+    return true;
+}
+
+void RoadBatch::setRoads(const std::vector<float>& vertices)
+{
+    if (!ready()) return;
+
+    GLint prevBuffer = 0;
+    glGetIntegerv(GL_ARRAY_BUFFER_BINDING, &prevBuffer);
+
+    glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+    glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)(vertices.size() * sizeof(float)),
+                 vertices.data(), GL_STATIC_DRAW);
+    vertexCount = vertices.size() / 2;
+
+    glBindBuffer(GL_ARRAY_BUFFER, (GLuint)prevBuffer);
+}
+
+void RoadBatch::draw(const Camera& camera, const float color[3], const std::vector<int>& roads)
+{
+    if (!ready() || vertexCount == 0 || roads.empty()) return;
+
+    indices.clear();
+    for (int r : roads) {
+        indices.push_back((unsigned int)r * 2);
+        indices.push_back((unsigned int)r * 2 + 1);
+    }
+
+    GLint prevProgram = 0, prevVao = 0;
+    glGetIntegerv(GL_CURRENT_PROGRAM, &prevProgram);
+    glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &prevVao);
+
+    glUseProgram(program);
+    glBindVertexArray(vao);
+
+    // as in UnitBatch, reallocating orphans the last frame's storage
+    size_t bytes = indices.size() * sizeof(unsigned int);
+    if (bytes > indexCapacity)
+        indexCapacity = bytes * 2;
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, (GLsizeiptr)indexCapacity, nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, (GLsizeiptr)bytes, indices.data());
+
+    glUniform2f(uCenter, camera.centerX, camera.centerY);
+    glUniform1f(uZoom, camera.zoom);
+    glUniform2f(uCanvas, camera.viewW, camera.viewH);
+    glUniform3fv(uColor, 1, color);
+
+    glDrawElements(GL_LINES, (GLsizei)indices.size(), GL_UNSIGNED_INT, nullptr);
+
+    glBindVertexArray((GLuint)prevVao);
+    glUseProgram((GLuint)prevProgram);
+}
+
+void RoadBatch::release()
+{
+    if (indexBuffer) glDeleteBuffers(1, &indexBuffer);
+    if (vertexBuffer) glDeleteBuffers(1, &vertexBuffer);
+    if (vao) glDeleteVertexArrays(1, &vao);
+    if (program) glDeleteProgram(program);
+
+    indexBuffer = vertexBuffer = vao = program = 0;
+    vertexCount = indexCapacity = 0;
+}
@@ -0,0 +1,46 @@
+#include "Ruleset.h"
+
+static_assert(Rules().sendInterval == StandardRules::sendInterval &&
+              Rules().produceInterval == StandardRules::produceInterval &&
+              Rules().unitSpeed == StandardRules::unitSpeed &&
+              Rules().redistributeMargin == StandardRules::redistributeMargin &&
+              Rules().unitStreams == StandardRules::unitStreams,
+              "default Rules must be the standard mode");
+
+Rules rulesFor(GameMode mode)
+{
+    switch (mode) {
+    case GameMode::Blitz: return rulesOf<BlitzRules>();
+    case GameMode::Siege: return rulesOf<SiegeRules>();
+    default: return rulesOf<StandardRules>();
+    }
+}
+
+GameMode modeOf(const Rules& rules)
+{
+    if (sameRules<StandardRules>(rules)) return GameMode::Standard;
+    if (sameRules<BlitzRules>(rules)) return GameMode::Blitz;
+    if (sameRules<SiegeRules>(rules)) return GameMode::Siege;
+    return GameMode::Custom;
+}
+
+const char* gameModeName(GameMode mode)
+{
+    switch (mode) {
+    case GameMode::Standard: return "standard";
+    case GameMode::Blitz: return "blitz";
+    case GameMode::Siege: return "siege";
+    default: return "custom";
+    }
+}
+
+bool parseGameMode(const std::string& name, GameMode& out)
+{
+    for (GameMode mode : { GameMode::Standard, GameMode::Blitz, GameMode::Siege }) {
+        if (name == gameModeName(mode)) {
+            out = mode;
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,436 @@
+#include "Server.h"
+#include "Varint.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+LockstepServer::LockstepServer(const ServerConfig& config)
+    : config(config), map(generateMap(config.layers, config.width, config.seed))
+{
+}
+
+LockstepServer::~LockstepServer()
+{
+    for (auto& entry : connections) ::close(entry.first);
+    if (timerFd >= 0) ::close(timerFd);
+    if (epollFd >= 0) ::close(epollFd);
+    if (listenFd >= 0) ::close(listenFd);
+}
+
+bool LockstepServer::start(std::string& error)
+{
+    listenFd = listenTcp(config.port, error);
+    if (listenFd < 0) return false;
+    boundPort = localPort(listenFd);
+
+    epollFd = epoll_create1(0);
+    timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK);
+    if (epollFd < 0 || timerFd < 0) {
+        error = std::string("epoll/timerfd: ") + std::strerror(errno);
+        return false;
+    }
+
+    itimerspec period = {};
+    period.it_interval.tv_nsec = 1000000000L / TICK_RATE;
+    period.it_value = period.it_interval;
+    timerfd_settime(timerFd, 0, &period, nullptr);
+
+    epoll_event ev = {};
+    ev.events = EPOLLIN;
+    ev.data.fd = listenFd;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd, &ev);
+    ev.data.fd = timerFd;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, timerFd, &ev);
+    return true;
+}
+
+void LockstepServer::run()
+{
+    while (!stopping)
+        poll(100);
+}
+
+void LockstepServer::poll(int timeoutMs)
+{
+    epoll_event events[256];
+    int n = epoll_wait(epollFd, events, 256, timeoutMs);
+
+    for (int i = 0; i < n; ++i) {
+        int fd = events[i].data.fd;
+
+        if (fd == listenFd) {
+            accept();
+        } else if (fd == timerFd) {
+            uint64_t expirations = 0;
+            if (read(timerFd, &expirations, sizeof(expirations)) == sizeof(expirations))
+                tickMatches(expirations);
+        } else {
+            auto it = connections.find(fd);
+            if (it == connections.end()) continue;
+            Connection& c = it->second;
+
+            if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+                drop(fd);
+                continue;
+            }
+            if (events[i].events & EPOLLIN) {
+                onReadable(c);
+                if (connections.find(fd) == connections.end()) continue;
+            }
+            if (events[i].events & EPOLLOUT) flush(c);
+        }
+    }
+
+    removeDeadMatches();
+}
+
+void LockstepServer::removeDeadMatches()
+{
+    for (uint32_t id : deadMatches) {
+        auto it = matches.find(id);
+        if (it == matches.end() || it->second->fds[0] >= 0 || it->second->fds[1] >= 0)
+            continue;
+
+        std::vector<int> watchers;
+        watchers.swap(it->second->watchers);
+        matches.erase(it);
+
+        for (int fd : watchers) {
+            auto c = connections.find(fd);
+            if (c != connections.end()) fail(c->second, "match closed");
+        }
+    }
+    deadMatches.clear();
+}
+
+void LockstepServer::accept()
+{
+    for (;;) {
+        int fd = accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK);
+        if (fd < 0) return;
+
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+        epoll_event ev = {};
+        ev.events = EPOLLIN;
+        ev.data.fd = fd;
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &ev);
+
+        connections[fd].fd = fd;
+        counters.connections++;
+    }
+}
+
+void LockstepServer::onReadable(Connection& c)
+{
+    int fd = c.fd;
+    if (!readSome(fd, c.in)) {
+        drop(fd);
+        return;
+    }
+
+    size_t offset = 0;
+    MsgType type;
+    const uint8_t* payload;
+    size_t size;
+    std::string error;
+
+    while (nextFrame(c.in, offset, type, payload, size, error)) {
+        onFrame(c, type, payload, size);
+        if (connections.find(fd) == connections.end() || c.closing) return;
+    }
+    if (!error.empty()) {
+        fail(c, error);
+        return;
+    }
+    c.in.erase(c.in.begin(), c.in.begin() + offset);
+}
+
+void LockstepServer::onFrame(Connection& c, MsgType type, const uint8_t* p, size_t size)
+{
+    const uint8_t* end = p + size;
+    uint64_t a, b, d;
+
+    switch (type) {
+    case MsgType::Hello:
+        if (c.joined || !getVarint(p, end, a) || !getVarint(p, end, b)) {
+            fail(c, "bad hello");
+            return;
+        }
+        if (b == WATCH_SIDE) watch(c, (uint32_t)a);
+        else join(c, (uint32_t)a, (int)b);
+        return;
+
+    case MsgType::Command: {
+        if (!c.joined || c.watching || !getVarint(p, end, a) || !getVarint(p, end, b) || !getVarint(p, end, d)) {
+            counters.rejected++;
+            return;
+        }
+        auto it = matches.find(c.match);
+        if (it == matches.end() || it->second->finished) return;
+
+        // queued commands wait for their tick, so a bounded lead and queue
+        // bound what one client can make the server hold
+        Match& m = *it->second;
+        if (a > (uint64_t)m.game.tick + (uint64_t)config.maxLead || m.queue.size() >= config.maxQueued) {
+            counters.rejected++;
+            return;
+        }
+
+        // only roads; the server alone starts a match
+        Command cmd{ CommandType::Connect, (int)b, (int)d };
+        m.queue.push_back({ (int)a, c.side, cmd });
+        return;
+    }
+
+    default:
+        fail(c, "unexpected message");
+        return;
+    }
+}
+
+void LockstepServer::join(Connection& c, uint32_t matchId, int wantSide)
+{
+    if (wantSide < 0 || wantSide > 2) {
+        fail(c, "bad side");
+        return;
+    }
+
+    std::unique_ptr<Match>& slot = matches[matchId];
+    if (!slot) {
+        slot.reset(new Match());
+        slot->id = matchId;
+        slot->game.load(map.view());
+    }
+    Match& m = *slot;
+
+    int side = -1;
+    if (wantSide == 0 || wantSide == 1) {
+        if (m.fds[wantSide] < 0) side = wantSide;
+    } else {
+        side = m.fds[0] < 0 ? 0 : m.fds[1] < 0 ? 1 : -1;
+    }
+    if (side < 0 || m.running || m.finished) {
+        fail(c, "match " + std::to_string(matchId) + " is full");
+        return;
+    }
+
+    m.fds[side] = c.fd;
+    c.joined = true;
+    c.match = matchId;
+    c.side = (Owner)side;
+
+    std::vector<uint8_t> snap;
+    m.game.snapshot(snap);
+
+    frame.clear();
+    size_t start = beginFrame(frame, MsgType::Welcome);
+    putVarint(frame, (uint64_t)side);
+    putVarint(frame, (uint64_t)config.inputDelay);
+    putVarint(frame, (uint64_t)TICK_RATE);
+    frame.insert(frame.end(), snap.begin(), snap.end());
+    finishFrame(frame, start);
+    send(c.fd, frame);
+
+    if (m.fds[0] >= 0 && m.fds[1] >= 0) {
+        // the Start goes out in the first batch like any other command
+        m.log.begin(m.game);
+        m.game.recorder = &m.log;
+        m.game.submit({ CommandType::Start });
+        m.running = true;
+        counters.matchesStarted++;
+    }
+}
+
+void LockstepServer::watch(Connection& c, uint32_t matchId)
+{
+    std::unique_ptr<Match>& slot = matches[matchId];
+    if (!slot) {
+        slot.reset(new Match());
+        slot->id = matchId;
+        slot->game.load(map.view());
+    }
+    Match& m = *slot;
+
+    c.joined = true;
+    c.watching = true;
+    c.match = matchId;
+    counters.spectators++;
+
+    // the first watcher restarts the stream, later ones get a keyframe of
+    // their own and then share it
+    if (m.watchers.empty()) {
+        m.spectate.requestKeyframe();
+        m.spectate.encode(m.game, spectateScratch);
+    } else {
+        SpectatorEncoder::keyframe(m.game, spectateScratch);
+    }
+    m.watchers.push_back(c.fd);
+    sendSpectate(c.fd, spectateScratch);
+}
+
+void LockstepServer::sendSpectate(int fd, const std::vector<uint8_t>& message)
+{
+    frame.clear();
+    size_t start = beginFrame(frame, MsgType::Spectate);
+    frame.insert(frame.end(), message.begin(), message.end());
+    finishFrame(frame, start);
+    counters.spectateBytes += (long long)frame.size();
+    send(fd, frame);
+}
+
+void LockstepServer::tickMatches(uint64_t steps)
+{
+    // behind by more than a few ticks: skip ahead rather than burst
+    if (steps > (uint64_t)MAX_CATCHUP_STEPS) steps = MAX_CATCHUP_STEPS;
+
+    auto start = std::chrono::steady_clock::now();
+    for (uint64_t s = 0; s < steps; ++s)
+        for (auto& entry : matches)
+            if (entry.second->running) stepMatch(*entry.second);
+    counters.stepSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void LockstepServer::stepMatch(Match& m)
+{
+    GlobalState& game = m.game;
+    int tick = game.tick;
+
+    // due commands, in arrival order; late ones go in now rather than
+    // being dropped. A command must come from the side owning its source.
+    size_t kept = 0;
+    for (size_t i = 0; i < m.queue.size(); ++i) {
+        const QueuedCommand& q = m.queue[i];
+        if (q.tick > tick) {
+            m.queue[kept++] = q;
+            continue;
+        }
+        const Node* from = game.nodeById(q.cmd.from);
+        if (from && from->owner == q.side) game.submit(q.cmd);
+        else counters.rejected++;
+    }
+    m.queue.resize(kept);
+
+    size_t logged = m.log.commands.size();
+    game.step();
+    counters.ticks++;
+    counters.commands += (long long)(m.log.commands.size() - logged);
+
+    bool withHash = game.gameOver || game.tick % config.hashInterval == 0;
+
+    frame.clear();
+    size_t start = beginFrame(frame, MsgType::Batch);
+    putVarint(frame, (uint64_t)tick);
+    putVarint(frame, withHash ? 1 : 0);
+    if (withHash) putVarint(frame, game.stateHash());
+    putVarint(frame, m.log.commands.size() - logged);
+    for (size_t i = logged; i < m.log.commands.size(); ++i) {
+        const Command& cmd = m.log.commands[i].cmd;
+        frame.push_back((uint8_t)cmd.type);
+        putVarint(frame, (uint64_t)(cmd.from + 1)); // -1 for Start
+        putVarint(frame, (uint64_t)(cmd.to + 1));
+    }
+    finishFrame(frame, start);
+
+    for (int fd : m.fds)
+        if (fd >= 0) send(fd, frame);
+
+    if (!m.watchers.empty()) {
+        m.spectate.encode(game, spectateScratch);
+        // a failed send drops the watcher, which edits m.watchers
+        fanout.assign(m.watchers.begin(), m.watchers.end());
+        for (int fd : fanout) sendSpectate(fd, spectateScratch);
+    }
+
+    if (game.gameOver || game.tick >= config.maxTicks) {
+        m.running = false;
+        m.finished = true;
+        counters.matchesFinished++;
+    }
+}
+
+void LockstepServer::send(int fd, const std::vector<uint8_t>& bytes)
+{
+    auto it = connections.find(fd);
+    if (it == connections.end()) return;
+    Connection& c = it->second;
+
+    bool idle = c.out.empty();
+    c.out.insert(c.out.end(), bytes.begin(), bytes.end());
+    if (c.out.size() > config.maxBacklog) {
+        // not reading; an error message would only queue behind the rest
+        counters.overflows++;
+        drop(fd);
+        return;
+    }
+    if (idle) flush(c);
+}
+
+void LockstepServer::flush(Connection& c)
+{
+    int fd = c.fd;
+    if (!writeSome(fd, c.out)) {
+        drop(fd);
+        return;
+    }
+    if (c.out.empty() && c.closing) {
+        drop(fd);
+        return;
+    }
+
+    // only ask for writability while there is a backlog
+    epoll_event ev = {};
+    ev.events = EPOLLIN | (c.out.empty() ? 0u : (uint32_t)EPOLLOUT);
+    ev.data.fd = fd;
+    epoll_ctl(epollFd, EPOLL_CTL_MOD, fd, &ev);
+}
+
+void LockstepServer::fail(Connection& c, const std::string& message)
+{
+    frame.clear();
+    size_t start = beginFrame(frame, MsgType::Error);
+    frame.insert(frame.end(), message.begin(), message.end());
+    finishFrame(frame, start);
+
+    c.closing = true;
+    send(c.fd, frame);
+}
+
+void LockstepServer::drop(int fd)
+{
+    auto it = connections.find(fd);
+    if (it == connections.end()) return;
+
+    if (it->second.joined) {
+        auto m = matches.find(it->second.match);
+        if (m != matches.end()) {
+            Match& match = *m->second;
+            for (int& slot : match.fds)
+                if (slot == fd) slot = -1;
+            auto w = std::find(match.watchers.begin(), match.watchers.end(), fd);
+            if (w != match.watchers.end()) match.watchers.erase(w);
+
+            // a match nobody is in any more is over; it may be mid-step
+            // here, so it is only removed after the event round. A leaving
+            // watcher only ends a match nobody else is in.
+            if (match.fds[0] < 0 && match.fds[1] < 0 &&
+                (!it->second.watching || match.watchers.empty())) {
+                if (match.running) counters.matchesFinished++;
+                match.running = false;
+                match.finished = true;
+                deadMatches.push_back(match.id);
+            }
+        }
+    }
+
+    epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+    ::close(fd);
+    connections.erase(it);
+}
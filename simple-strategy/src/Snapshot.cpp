@@ -0,0 +1,336 @@
+#include "Snapshot.h"
+#include "GlobalState.h"
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static_assert(sizeof(Owner) == sizeof(int32_t), "Owner is stored as int32");
+static_assert(sizeof(Road) == sizeof(SnapshotRoad), "roads are copied as one block");
+static_assert(sizeof(SnapshotHeader) % 8 == 0, "sections after the header stay aligned");
+
+static size_t align4(size_t n)
+{
+    return (n + 3) & ~(size_t)3;
+}
+
+static size_t align8(size_t n)
+{
+    return (n + 7) & ~(size_t)7;
+}
+
+// Byte offset of every section for the given counts.
+struct SnapshotLayout {
+    size_t nodes, sendTimer, productionTimer, roundRobin, sendPhase, supplied;
+    size_t links, roads, depart, arrive, speed, from, to, owner, stride, members, pending, size;
+
+    SnapshotLayout(uint32_t nodeCount, uint32_t linkCount, uint32_t roadCount,
+                   uint32_t unitCount, uint32_t pendingCount)
+    {
+        size_t n = nodeCount, u = unitCount;
+        nodes = sizeof(SnapshotHeader);
+        sendTimer = nodes + n * sizeof(SnapshotNode);
+        productionTimer = sendTimer + n * sizeof(float);
+        roundRobin = productionTimer + n * sizeof(float);
+        sendPhase = roundRobin + n * sizeof(int32_t);
+        supplied = sendPhase + align4(n);
+        links = supplied + align4(n);
+        roads = links + (size_t)linkCount * sizeof(int32_t);
+        depart = roads + (size_t)roadCount * sizeof(SnapshotRoad);
+        arrive = depart + u * sizeof(int32_t);
+        speed = arrive + u * sizeof(int32_t);
+        from = speed + u * sizeof(float);
+        to = from + u * sizeof(int32_t);
+        owner = to + u * sizeof(int32_t);
+        stride = owner + u * sizeof(int32_t);
+        members = align8(stride + u * sizeof(int32_t));
+        pending = members + u * sizeof(uint64_t);
+        size = pending + (size_t)pendingCount * sizeof(SnapshotCommand);
+    }
+};
+
+void writeSnapshot(const GlobalState& game, std::vector<uint8_t>& out)
+{
+    uint32_t nodeCount = (uint32_t)game.nodes.size();
+    uint32_t linkCount = 0;
+    for (const Node& n : game.nodes)
+        linkCount += (uint32_t)(n.edges.size() + n.forward.size() + n.lateral.size());
+    uint32_t unitCount = (uint32_t)game.units.size();
+
+    SnapshotLayout at(nodeCount, linkCount, (uint32_t)game.roads.size(), unitCount,
+                      (uint32_t)game.pending.size());
+    out.resize(at.size);
+    uint8_t* base = out.data();
+
+    SnapshotHeader* h = (SnapshotHeader*)base;
+    std::memset(h, 0, sizeof(*h));
+    std::memcpy(h->magic, SNAPSHOT_MAGIC, 4);
+    h->version = SNAPSHOT_VERSION;
+    h->nodeCount = nodeCount;
+    h->linkCount = linkCount;
+    h->roadCount = (uint32_t)game.roads.size();
+    h->unitCount = unitCount;
+    h->pendingCount = (uint32_t)game.pending.size();
+    h->tick = game.tick;
+    h->playerBase = game.playerBase;
+    h->enemyBase = game.enemyBase;
+    h->gameStarted = game.gameStarted;
+    h->gameOver = game.gameOver;
+    h->winner = (uint8_t)game.winner;
+    h->sendInterval = game.rules.sendInterval;
+    h->produceInterval = game.rules.produceInterval;
+    h->unitSpeed = game.rules.unitSpeed;
+    h->redistributeMargin = game.rules.redistributeMargin;
+    h->unitStreams = game.rules.unitStreams;
+    h->clockAccumulator = game.clock.accumulator;
+
+    SnapshotNode* nodes = (SnapshotNode*)(base + at.nodes);
+    int32_t* links = (int32_t*)(base + at.links);
+    for (uint32_t i = 0; i < nodeCount; ++i) {
+        const Node& n = game.nodes[i];
+        SnapshotNode& s = nodes[i];
+        s.x = n.x;
+        s.y = n.y;
+        s.layer = n.layer;
+        s.owner = (int32_t)n.owner;
+        s.capacity = n.capacity;
+        s.unitCount = n.unitCount;
+        s.edgeCount = (uint32_t)n.edges.size();
+        s.forwardCount = (uint32_t)n.forward.size();
+        s.lateralCount = (uint32_t)n.lateral.size();
+
+        for (int id : n.edges) *links++ = id;
+        for (int id : n.forward) *links++ = id;
+        for (int id : n.lateral) *links++ = id;
+    }
+
+    // the byte columns are padded; keep the padding deterministic
+    std::memset(base + at.sendPhase, 0, at.links - at.sendPhase);
+
+    auto put = [base](size_t offset, const void* src, size_t bytes) {
+        if (bytes) std::memcpy(base + offset, src, bytes);
+    };
+    put(at.sendTimer, game.sendTimer.data(), nodeCount * sizeof(float));
+    put(at.productionTimer, game.productionTimer.data(), nodeCount * sizeof(float));
+    put(at.roundRobin, game.roundRobin.data(), nodeCount * sizeof(int32_t));
+    put(at.sendPhase, game.sendPhase.data(), nodeCount);
+    put(at.supplied, game.supplied.data(), nodeCount);
+    put(at.roads, game.roads.data(), game.roads.size() * sizeof(SnapshotRoad));
+    put(at.depart, game.units.depart.data(), unitCount * sizeof(int32_t));
+    put(at.arrive, game.units.arrive.data(), unitCount * sizeof(int32_t));
+    put(at.speed, game.units.speed.data(), unitCount * sizeof(float));
+    put(at.from, game.units.from.data(), unitCount * sizeof(int32_t));
+    put(at.to, game.units.to.data(), unitCount * sizeof(int32_t));
+    put(at.owner, game.units.owner.data(), unitCount * sizeof(int32_t));
+    put(at.stride, game.units.stride.data(), unitCount * sizeof(int32_t));
+    put(at.members, game.units.members.data(), unitCount * sizeof(uint64_t));
+
+    SnapshotCommand* pending = (SnapshotCommand*)(base + at.pending);
+    for (const Command& c : game.pending)
+        *pending++ = { (int32_t)c.type, c.from, c.to };
+}
+
+bool parseSnapshot(const void* data, size_t size, SnapshotView& out, std::string& error)
+{
+    const uint8_t* base = (const uint8_t*)data;
+    const SnapshotHeader* h = (const SnapshotHeader*)base;
+
+    if (size < sizeof(SnapshotHeader) || std::memcmp(h->magic, SNAPSHOT_MAGIC, 4) != 0) {
+        error = "not a snapshot";
+        return false;
+    }
+    if (h->version != SNAPSHOT_VERSION) {
+        error = "unsupported snapshot version";
+        return false;
+    }
+
+    SnapshotLayout at(h->nodeCount, h->linkCount, h->roadCount, h->unitCount, h->pendingCount);
+    if (size < at.size) {
+        error = "truncated snapshot";
+        return false;
+    }
+
+    SnapshotView v;
+    v.header = h;
+    v.nodes = (const SnapshotNode*)(base + at.nodes);
+    v.sendTimer = (const float*)(base + at.sendTimer);
+    v.productionTimer = (const float*)(base + at.productionTimer);
+    v.roundRobin = (const int32_t*)(base + at.roundRobin);
+    v.sendPhase = base + at.sendPhase;
+    v.supplied = base + at.supplied;
+    v.links = (const int32_t*)(base + at.links);
+    v.roads = (const SnapshotRoad*)(base + at.roads);
+    v.depart = (const int32_t*)(base + at.depart);
+    v.arrive = (const int32_t*)(base + at.arrive);
+    v.speed = (const float*)(base + at.speed);
+    v.from = (const int32_t*)(base + at.from);
+    v.to = (const int32_t*)(base + at.to);
+    v.owner = (const int32_t*)(base + at.owner);
+    v.stride = (const int32_t*)(base + at.stride);
+    v.members = (const uint64_t*)(base + at.members);
+    v.pending = (const SnapshotCommand*)(base + at.pending);
+
+    int n = (int)h->nodeCount;
+    auto validId = [n](int32_t id) { return id >= 0 && id < n; };
+    auto validOwner = [](int32_t o) { return o == (int32_t)Owner::Player || o == (int32_t)Owner::Enemy; };
+
+    if (h->nodeCount > 0x7fffffffu) {
+        error = "too many nodes";
+        return false;
+    }
+    if (!validId(h->playerBase) || !validId(h->enemyBase) || h->playerBase == h->enemyBase ||
+        !validOwner(h->winner)) {
+        error = "bad base or winner";
+        return false;
+    }
+
+    Rules rules;
+    rules.sendInterval = h->sendInterval;
+    rules.produceInterval = h->produceInterval;
+    rules.unitSpeed = h->unitSpeed;
+    if (!rules.valid() || h->unitStreams > 1) {
+        error = "bad rules";
+        return false;
+    }
+
+    uint64_t links = 0;
+    for (int i = 0; i < n; ++i) {
+        const SnapshotNode& s = v.nodes[i];
+        if (!validOwner(s.owner)) {
+            error = "bad owner on node " + std::to_string(i);
+            return false;
+        }
+        // same bounds as validateMap; NaN fails the comparison
+        if (!(std::fabs(s.x) <= MAP_EXTENT) || !(std::fabs(s.y) <= MAP_EXTENT)) {
+            error = "bad position on node " + std::to_string(i);
+            return false;
+        }
+        if (s.capacity <= 0 || s.unitCount < 0 || s.unitCount > s.capacity) {
+            error = "bad capacity or unit count on node " + std::to_string(i);
+            return false;
+        }
+        // roundRobin indexes adjacency lists modulo their size
+        if (v.roundRobin[i] < 0 || v.sendPhase[i] > 1 || v.supplied[i] > 1) {
+            error = "bad tick state on node " + std::to_string(i);
+            return false;
+        }
+        links += (uint64_t)s.edgeCount + s.forwardCount + s.lateralCount;
+    }
+    if (links != h->linkCount) {
+        error = "node link counts do not add up";
+        return false;
+    }
+    for (uint32_t i = 0; i < h->linkCount; ++i) {
+        if (!validId(v.links[i])) {
+            error = "bad node id in links";
+            return false;
+        }
+    }
+    for (uint32_t i = 0; i < h->roadCount; ++i) {
+        if (!validId(v.roads[i].a) || !validId(v.roads[i].b)) {
+            error = "bad node id in roads";
+            return false;
+        }
+    }
+    for (uint32_t i = 0; i < h->unitCount; ++i) {
+        if (!validId(v.from[i]) || !validId(v.to[i]) || !validOwner(v.owner[i]) ||
+            !(v.members[i] & 1) || v.stride[i] < 0 ||
+            ((v.members[i] & ~1ull) && v.stride[i] == 0)) {
+            error = "bad unit " + std::to_string(i);
+            return false;
+        }
+    }
+    for (uint32_t i = 0; i < h->pendingCount; ++i) {
+        const SnapshotCommand& c = v.pending[i];
+        if (c.type != (int32_t)CommandType::Start && c.type != (int32_t)CommandType::Connect) {
+            error = "bad pending command";
+            return false;
+        }
+    }
+
+    out = v;
+    return true;
+}
+
+bool isSnapshot(const std::string& path)
+{
+    FILE* f = std::fopen(path.c_str(), "rb");
+    if (!f) return false;
+
+    char magic[4] = {};
+    size_t got = std::fread(magic, 1, 4, f);
+    std::fclose(f);
+
+    return got == 4 && std::memcmp(magic, SNAPSHOT_MAGIC, 4) == 0;
+}
+
+bool saveSnapshot(const std::string& path, const GlobalState& game, std::string& error)
+{
+    std::vector<uint8_t> bytes;
+    writeSnapshot(game, bytes);
+
+    FILE* f = std::fopen(path.c_str(), "wb");
+    if (!f) {
+        error = path + ": " + std::strerror(errno);
+        return false;
+    }
+
+    bool ok = std::fwrite(bytes.data(), 1, bytes.size(), f) == bytes.size();
+    if (std::fclose(f) != 0) ok = false;
+    if (!ok) error = path + ": write failed";
+    return ok;
+}
+
+SnapshotFile::~SnapshotFile()
+{
+    close();
+}
+
+void SnapshotFile::close()
+{
+    if (data) munmap(data, size);
+    data = nullptr;
+    size = 0;
+    snapView = SnapshotView();
+}
+
+bool SnapshotFile::open(const std::string& path, std::string& error)
+{
+    close();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        error = path + ": " + std::strerror(errno);
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(SnapshotHeader)) {
+        ::close(fd);
+        error = path + ": not a snapshot";
+        return false;
+    }
+
+    size = (size_t)st.st_size;
+    data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+
+    if (data == MAP_FAILED) {
+        data = nullptr;
+        size = 0;
+        error = path + ": " + std::strerror(errno);
+        return false;
+    }
+
+    std::string why;
+    if (!parseSnapshot(data, size, snapView, why)) {
+        close();
+        error = path + ": " + why;
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,89 @@
+#include "SpatialGrid.h"
+#include <algorithm>
+#include <cmath>
+
+// however the nodes are spread, the grid never has more cells than this
+static constexpr double MAX_GRID_CELLS = 1 << 22;
+
+void SpatialGrid::build(const std::vector<Node>& nodes)
+{
+    cols = rows = 0;
+    cellStart.clear();
+    items.clear();
+    if (nodes.empty()) return;
+
+    // the extent only counts finite positions; anything else is clamped
+    // into the border cells like a point outside the grid
+    double minX = 0.0, maxX = 0.0, minY = 0.0, maxY = 0.0;
+    bool any = false;
+    for (const Node& n : nodes) {
+        if (!std::isfinite(n.x) || !std::isfinite(n.y)) continue;
+        if (!any) {
+            minX = maxX = n.x;
+            minY = maxY = n.y;
+            any = true;
+        }
+        minX = std::min(minX, (double)n.x); maxX = std::max(maxX, (double)n.x);
+        minY = std::min(minY, (double)n.y); maxY = std::max(maxY, (double)n.y);
+    }
+
+    // about a node per cell, but never more than a few cells per node on
+    // sparse maps, and never more than MAX_GRID_CELLS
+    double size = 2.0 * NODE_RADIUS + 1.0;
+    double area = (maxX - minX + size) * (maxY - minY + size);
+    double maxCells = std::min(4.0 * nodes.size() + 64.0, MAX_GRID_CELLS);
+    if (area / (size * size) > maxCells)
+        size = std::sqrt(area / maxCells);
+    while (((maxX - minX) / size + 1.0) * ((maxY - minY) / size + 1.0) > MAX_GRID_CELLS)
+        size *= 2.0;
+
+    cellSize = (float)size;
+    originX = (float)minX;
+    originY = (float)minY;
+    cols = (int)((maxX - minX) / size) + 1;
+    rows = (int)((maxY - minY) / size) + 1;
+
+    // counting sort of node ids by cell
+    cellStart.assign((size_t)cols * rows + 1, 0);
+    for (const Node& n : nodes)
+        cellStart[cellY(n.y) * cols + cellX(n.x) + 1]++;
+    for (size_t c = 1; c < cellStart.size(); ++c)
+        cellStart[c] += cellStart[c - 1];
+
+    items.resize(nodes.size());
+    std::vector<int> fill(cellStart.begin(), cellStart.end() - 1);
+    for (const Node& n : nodes)
+        items[fill[cellY(n.y) * cols + cellX(n.x)]++] = n.id;
+}
+
+// clamped in float first, so huge or NaN coordinates never reach the cast
+int SpatialGrid::cellX(float x) const
+{
+    float c = std::floor((x - originX) / cellSize);
+    if (!(c >= 0.0f)) return 0;
+    return c >= (float)(cols - 1) ? cols - 1 : (int)c;
+}
+
+int SpatialGrid::cellY(float y) const
+{
+    float c = std::floor((y - originY) / cellSize);
+    if (!(c >= 0.0f)) return 0;
+    return c >= (float)(rows - 1) ? rows - 1 : (int)c;
+}
+
+int SpatialGrid::pick(const std::vector<Node>& nodes, float x, float y) const
+{
+    int found = -1;
+    forEachInRect(nodes, x, y, x, y, [&](int id) {
+        // lowest id wins where disks overlap, as with a linear scan
+        if (nodes[id].contains(x, y) && (found < 0 || id < found))
+            found = id;
+    });
+    return found;
+}
+
+void SpatialGrid::query(const std::vector<Node>& nodes, float minX, float minY,
+                        float maxX, float maxY, std::vector<int>& out) const
+{
+    forEachInRect(nodes, minX, minY, maxX, maxY, [&](int id) { out.push_back(id); });
+}
@@ -0,0 +1,291 @@
+#include "Spectator.h"
+#include "Varint.h"
+
+static uint8_t stateFlags(const GlobalState& game)
+{
+    return (uint8_t)((game.gameStarted ? 1 : 0) | (game.gameOver ? 2 : 0) |
+                     (game.winner == Owner::Enemy ? 4 : 0));
+}
+
+SpectatorEncoder::SpectatorEncoder(int keyframeInterval)
+    : keyframeInterval(keyframeInterval)
+{
+}
+
+void SpectatorEncoder::keyframe(const GlobalState& game, std::vector<uint8_t>& out)
+{
+    std::vector<uint8_t> image;
+    writeSnapshot(game, image);
+    out.clear();
+    out.push_back('K');
+    out.insert(out.end(), image.begin(), image.end());
+}
+
+void SpectatorEncoder::sync(const GlobalState& game)
+{
+    const size_t count = game.nodes.size();
+    owner.resize(count);
+    unitCount.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        owner[i] = (uint8_t)game.nodes[i].owner;
+        unitCount[i] = game.nodes[i].unitCount;
+    }
+    tick = game.tick;
+    flags = stateFlags(game);
+    roads = game.roads.size();
+    units = game.units.size();
+    lastKeyframe = game.tick;
+    synced = true;
+}
+
+void SpectatorEncoder::encode(const GlobalState& game, std::vector<uint8_t>& out)
+{
+    // a delta can only describe nothing or exactly one step since the last
+    // message; anything else sends the whole state
+    bool stepped = game.tick == tick + 1;
+    bool keyed = !synced || game.nodes.size() != owner.size() || game.roads.size() < roads ||
+                 (!stepped && (game.tick != tick || game.units.size() != units));
+
+    if (keyed) {
+        writeSnapshot(game, image);
+        out.clear();
+        out.push_back('K');
+        out.insert(out.end(), image.begin(), image.end());
+        sync(game);
+        keyframes++;
+        return;
+    }
+
+    out.clear();
+    out.push_back('D');
+    putVarint(out, (uint64_t)game.tick);
+    out.push_back(stateFlags(game));
+
+    changed.clear();
+    const size_t count = game.nodes.size();
+    for (size_t i = 0; i < count; ++i) {
+        const Node& n = game.nodes[i];
+        if ((uint8_t)n.owner != owner[i] || n.unitCount != unitCount[i]) {
+            changed.push_back((int)i);
+            owner[i] = (uint8_t)n.owner;
+            unitCount[i] = n.unitCount;
+        }
+    }
+    putVarint(out, changed.size());
+    int previous = -1;
+    for (int id : changed) {
+        const Node& n = game.nodes[id];
+        putVarint(out, ((uint64_t)(id - previous - 1) << 1) | (uint64_t)n.owner);
+        putSignedVarint(out, n.unitCount);
+        previous = id;
+    }
+
+    putVarint(out, game.roads.size() - roads);
+    for (size_t i = roads; i < game.roads.size(); ++i) {
+        putVarint(out, (uint64_t)game.roads[i].a);
+        putVarint(out, (uint64_t)game.roads[i].b);
+    }
+
+    if (stepped) {
+        putVarint(out, game.sent.size());
+        for (const SentUnit& u : game.sent) {
+            putVarint(out, ((uint64_t)u.from << 1) | (uint64_t)u.owner);
+            putVarint(out, (uint64_t)u.to);
+        }
+    } else {
+        putVarint(out, 0);
+    }
+
+    if (stepped) {
+        putVarint(out, game.arrivals.size());
+        uint32_t at = 0;
+        for (uint32_t pos : game.arrivals) {
+            putVarint(out, pos - at);
+            at = pos;
+        }
+    } else {
+        putVarint(out, 0);
+    }
+
+    tick = game.tick;
+    flags = stateFlags(game);
+    roads = game.roads.size();
+    units = game.units.size();
+    deltas++;
+
+    // periodic keyframes follow the delta of their tick, so a decoder can
+    // check the state its deltas built before replacing it
+    if (game.tick - lastKeyframe >= keyframeInterval) {
+        writeSnapshot(game, image);
+        out.push_back('K');
+        out.insert(out.end(), image.begin(), image.end());
+        lastKeyframe = game.tick;
+        keyframes++;
+    }
+}
+
+bool SpectatorDecoder::matches(const GlobalState& view, const SnapshotView& snap) const
+{
+    const SnapshotHeader& h = *snap.header;
+    if ((int)h.tick != view.tick || h.nodeCount != view.nodes.size() ||
+        h.unitCount != view.units.size() || h.roadCount != view.roads.size())
+        return false;
+
+    for (uint32_t i = 0; i < h.nodeCount; ++i)
+        if (snap.nodes[i].owner != (int32_t)view.nodes[i].owner ||
+            snap.nodes[i].unitCount != view.nodes[i].unitCount)
+            return false;
+    return true;
+}
+
+bool SpectatorDecoder::apply(GlobalState& view, const uint8_t* p, size_t size, std::string& error)
+{
+    if (size == 0) {
+        error = "empty spectator message";
+        return false;
+    }
+
+    const uint8_t* end = p + size;
+
+    if (p[0] == 'D') {
+        if (!haveKeyframe) {
+            error = "delta before the first keyframe";
+            return false;
+        }
+        ++p;
+        if (!applyDelta(view, p, end, error)) {
+            // wait for the next keyframe rather than drawing a wrong state
+            haveKeyframe = false;
+            return false;
+        }
+        deltas++;
+        if (p == end) return true;
+    }
+
+    if (p[0] != 'K') {
+        error = "unknown spectator message";
+        return false;
+    }
+
+    // the payload sits at an arbitrary offset; snapshots want alignment
+    snapshot.assign(p + 1, end);
+    SnapshotView snap;
+    if (!parseSnapshot(snapshot.data(), snapshot.size(), snap, error)) {
+        haveKeyframe = false;
+        return false;
+    }
+    if (haveKeyframe && !matches(view, snap)) mismatches++;
+
+    view.restore(snap);
+    haveKeyframe = true;
+    keyframes++;
+    return true;
+}
+
+bool SpectatorDecoder::applyDelta(GlobalState& view, const uint8_t*& p, const uint8_t* end,
+                                  std::string& error)
+{
+    uint64_t tick, count, a, b;
+    int64_t value;
+
+    if (!getVarint(p, end, tick) || p >= end) {
+        error = "truncated delta";
+        return false;
+    }
+    bool stepped = (int)tick == view.tick + 1;
+    if (!stepped && (int)tick != view.tick) {
+        error = "delta for tick " + std::to_string(tick) + ", view is at " + std::to_string(view.tick);
+        return false;
+    }
+
+    uint8_t flags = *p++;
+    view.gameStarted = (flags & 1) != 0;
+    view.gameOver = (flags & 2) != 0;
+    view.winner = (flags & 4) ? Owner::Enemy : Owner::Player;
+
+    const size_t nodeCount = view.nodes.size();
+
+    if (!getVarint(p, end, count)) {
+        error = "truncated delta";
+        return false;
+    }
+    int64_t id = -1;
+    for (uint64_t i = 0; i < count; ++i) {
+        if (!getVarint(p, end, a) || !getSignedVarint(p, end, value)) {
+            error = "truncated delta";
+            return false;
+        }
+        id += (int64_t)(a >> 1) + 1;
+        if (id >= (int64_t)nodeCount) {
+            error = "delta names a node that does not exist";
+            return false;
+        }
+        Node& n = view.nodes[id];
+        n.owner = (Owner)(a & 1);
+        n.unitCount = (int)value;
+    }
+
+    if (!getVarint(p, end, count)) {
+        error = "truncated delta";
+        return false;
+    }
+    for (uint64_t i = 0; i < count; ++i) {
+        if (!getVarint(p, end, a) || !getVarint(p, end, b) || a >= nodeCount || b >= nodeCount) {
+            error = "bad road in delta";
+            return false;
+        }
+        view.createSharedConnection(&view.nodes[a], &view.nodes[b]);
+    }
+
+    // spawns belong to the new tick; the view is never stepped, so its
+    // sent list is cleared here as step() would
+    if (stepped) {
+        view.tick = (int)tick;
+        view.sent.clear();
+    }
+
+    if (!getVarint(p, end, count)) {
+        error = "truncated delta";
+        return false;
+    }
+    for (uint64_t i = 0; i < count; ++i) {
+        if (!getVarint(p, end, a) || !getVarint(p, end, b) || (a >> 1) >= nodeCount || b >= nodeCount) {
+            error = "bad unit in delta";
+            return false;
+        }
+        view.spawnUnit((int)(a >> 1), (int)b, (Owner)(a & 1));
+    }
+
+    if (!getVarint(p, end, count)) {
+        error = "truncated delta";
+        return false;
+    }
+    removals.clear();
+    uint64_t at = 0;
+    for (uint64_t i = 0; i < count; ++i) {
+        if (!getVarint(p, end, a)) {
+            error = "truncated delta";
+            return false;
+        }
+        at += a;
+        removals.push_back((uint32_t)at);
+    }
+
+    if (!stepped) {
+        if (!removals.empty()) {
+            error = "units removed without a step";
+            return false;
+        }
+        return true;
+    }
+
+    // the view schedules arrivals just like the server, so the same units
+    // land; the removal list is the check that they did
+    view.collectArrivals();
+    if (removals != view.arrivals) {
+        error = "spectator view out of step at tick " + std::to_string(tick);
+        return false;
+    }
+    view.retireArrivals();
+    return true;
+}
@@ -0,0 +1,22 @@
+#include "TickClock.h"
+
+int TickClock::advance(float dt_ms)
+{
+    if (dt_ms > 0.0f)
+        accumulator += dt_ms;
+
+    int steps = (int)(accumulator / TICK_MS);
+    if (steps > MAX_CATCHUP_STEPS) {
+        steps = MAX_CATCHUP_STEPS;
+        accumulator = 0.0;
+        return steps;
+    }
+
+    accumulator -= steps * (double)TICK_MS;
+    return steps;
+}
+
+float TickClock::alpha() const
+{
+    return (float)(accumulator / TICK_MS);
+}
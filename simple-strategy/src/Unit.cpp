@@ -1,26 +1,19 @@
 #include "Unit.h"
-#include <graphics.h>
 
-Unit::Unit(Node* from, Node* to, Owner owner)
-    : from(from), to(to), owner(owner) {}
+int travelTicks(float speed, float dt)
+{
+    float step = dt * speed;
+    if (!(step > 0.0f)) return 0;
 
-void Unit::update(float dt) {
-    t += dt * 0.5f;
-    if (t > 1.0f) t = 1.0f;
-}
-
-bool Unit::arrived() const {
-    return t >= 1.0f;
-}
-
-void Unit::draw() {
-    float x = from->x + (to->x - from->x) * t;
-    float y = from->y + (to->y - from->y) * t;
-
-    graphics::Brush br;
-    br.fill_color[0] = owner == Owner::Player ? 0.2f : 1.0f;
-    br.fill_color[1] = owner == Owner::Player ? 1.0f : 0.2f;
-    br.fill_color[2] = 0.2f;
-
-    graphics::drawDisk(x, y, 5, br);
+    // a step too small to move t any more never gets there either
+    int ticks = 0;
+    float t = 0.0f;
+    while (t < 1.0f) {
+        float next = t + step;
+        if (next > 1.0f) next = 1.0f;
+        if (next == t) return 0;
+        t = next;
+        ticks++;
+    }
+    return ticks;
 }
@@ -0,0 +1,190 @@
+#include "UnitBatch.h"
+#include <GL/glew.h>
+#include <cstdio>
+
+static const char* VERTEX_SHADER = R"(#version 330 core
+layout(location = 0) in vec2 corner;   // unit quad, -1..1
+layout(location = 1) in vec2 center;   // per instance, canvas units
+uniform vec2 canvas;
+uniform float radius;
+out vec2 local;
+void main()
+{
+    local = corner;
+    vec2 p = center + corner * radius;
+    gl_Position = vec4(p.x / canvas.x * 2.0 - 1.0, 1.0 - p.y / canvas.y * 2.0, 0.0, 1.0);
+}
+)";
+
+static const char* FRAGMENT_SHADER = R"(#version 330 core
+in vec2 local;
+uniform vec3 color;
+out vec4 fragColor;
+void main()
+{
+    float d = length(local);
+    float edge = fwidth(d);
+    float a = 1.0 - smoothstep(1.0 - edge, 1.0, d);
+    if (a <= 0.0) discard;
+    fragColor = vec4(color, a);
+}
+)";
+
+static GLuint compileShader(GLenum type, const char* source)
+{
+    GLuint shader = glCreateShader(type);
+    glShaderSource(shader, 1, &source, nullptr);
+    glCompileShader(shader);
+
+    GLint ok = GL_FALSE;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &ok);
+    if (!ok) {
+        char log[512];
+        glGetShaderInfoLog(shader, sizeof(log), nullptr, log);
+        std::fprintf(stderr, "UnitBatch: shader: %s\n", log);
+        glDeleteShader(shader);
+        return 0;
+    }
+    return shader;
+}
+
+bool UnitBatch::init()
+{
+    if (ready()) return true;
+
+    // SGG initialises GLEW itself; this only makes sure the entry points
+    // are loaded if it has not happened yet
+    glewExperimental = GL_TRUE;
+    if (glewInit() != GLEW_OK || !GLEW_VERSION_3_3) return false;
+
+    GLuint vs = compileShader(GL_VERTEX_SHADER, VERTEX_SHADER);
+    GLuint fs = compileShader(GL_FRAGMENT_SHADER, FRAGMENT_SHADER);
+    if (!vs || !fs) {
+        if (vs) glDeleteShader(vs);
+        if (fs) glDeleteShader(fs);
+        return false;
+    }
+
+    program = glCreateProgram();
+    glAttachShader(program, vs);
+    glAttachShader(program, fs);
+    glLinkProgram(program);
+    glDeleteShader(vs);
+    glDeleteShader(fs);
+
+    GLint ok = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &ok);
+    if (!ok) {
+        glDeleteProgram(program);
+        program = 0;
+        return false;
+    }
+
+    uCanvas = glGetUniformLocation(program, "canvas");
+    uRadius = glGetUniformLocation(program, "radius");
+    uColor = glGetUniformLocation(program, "color");
+
+    const float quad[] = { -1.0f, -1.0f, 1.0f, -1.0f, -1.0f, 1.0f, 1.0f, 1.0f };
+
+    GLint prevVao = 0, prevBuffer = 0;
+    glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &prevVao);
+    glGetIntegerv(GL_ARRAY_BUFFER_BINDING, &prevBuffer);
+
+    glGenVertexArrays(1, &vao);
+    glBindVertexArray(vao);
+
+    glGenBuffers(1, &quadBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, quadBuffer);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(quad), quad, GL_STATIC_DRAW);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, nullptr);
+
+    glGenBuffers(1, &instanceBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+    glEnableVertexAttribArray(1);
+    glVertexAttribDivisor(1, 1);
+
+    glBindVertexArray((GLuint)prevVao);
+    glBindBuffer(GL_ARRAY_BUFFER, (GLuint)prevBuffer);
+    return true;
+}
+
+void UnitBatch::flush(float canvasW, float canvasH, float radius)
+{
+    size_t counts[2] = { staged[0].size() / 2, staged[1].size() / 2 };
+    if (!ready() || counts[0] + counts[1] == 0) {
+        staged[0].clear();
+        staged[1].clear();
+        return;
+    }
+
+    // both owners in one upload, player first
+    upload.clear();
+    upload.insert(upload.end(), staged[0].begin(), staged[0].end());
+    upload.insert(upload.end(), staged[1].begin(), staged[1].end());
+    staged[0].clear();
+    staged[1].clear();
+
+    GLint prevProgram = 0, prevVao = 0, prevBuffer = 0;
+    glGetIntegerv(GL_CURRENT_PROGRAM, &prevProgram);
+    glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &prevVao);
+    glGetIntegerv(GL_ARRAY_BUFFER_BINDING, &prevBuffer);
+    GLboolean blend = glIsEnabled(GL_BLEND);
+    GLint blendSrcRgb = 0, blendDstRgb = 0, blendSrcAlpha = 0, blendDstAlpha = 0;
+    glGetIntegerv(GL_BLEND_SRC_RGB, &blendSrcRgb);
+    glGetIntegerv(GL_BLEND_DST_RGB, &blendDstRgb);
+    glGetIntegerv(GL_BLEND_SRC_ALPHA, &blendSrcAlpha);
+    glGetIntegerv(GL_BLEND_DST_ALPHA, &blendDstAlpha);
+
+    glUseProgram(program);
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+
+    // (re)allocating every frame also orphans last frame's storage, so the
+    // driver does not stall on a draw that may still be reading it
+    size_t bytes = upload.size() * sizeof(float);
+    if (bytes > instanceCapacity)
+        instanceCapacity = bytes * 2;
+    glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)instanceCapacity, nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, (GLsizeiptr)bytes, upload.data());
+
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    glUniform2f(uCanvas, canvasW, canvasH);
+    glUniform1f(uRadius, radius);
+
+    static const float colors[2][3] = {
+        { 0.2f, 1.0f, 0.2f }, // Player, as in Frontend::drawUnit
+        { 1.0f, 0.2f, 0.2f }  // Enemy
+    };
+
+    size_t first = 0;
+    for (int side = 0; side < 2; ++side) {
+        if (counts[side] == 0) continue;
+
+        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 0,
+                              (const void*)(first * 2 * sizeof(float)));
+        glUniform3fv(uColor, 1, colors[side]);
+        glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, (GLsizei)counts[side]);
+        first += counts[side];
+    }
+
+    glBlendFuncSeparate((GLenum)blendSrcRgb, (GLenum)blendDstRgb, (GLenum)blendSrcAlpha,
+                        (GLenum)blendDstAlpha);
+    if (!blend) glDisable(GL_BLEND);
+    glBindBuffer(GL_ARRAY_BUFFER, (GLuint)prevBuffer);
+    glBindVertexArray((GLuint)prevVao);
+    glUseProgram((GLuint)prevProgram);
+}
+
+void UnitBatch::release()
+{
+    if (instanceBuffer) glDeleteBuffers(1, &instanceBuffer);
+    if (quadBuffer) glDeleteBuffers(1, &quadBuffer);
+    if (vao) glDeleteVertexArrays(1, &vao);
+    if (program) glDeleteProgram(program);
+
+    instanceBuffer = quadBuffer = vao = program = 0;
+    instanceCapacity = 0;
+}
@@ -0,0 +1,157 @@
+#include "UnitPool.h"
+
+UnitHandle UnitPool::spawn(int fromId, int toId, Owner who, float unitSpeed, int departTick,
+                           int arriveTick)
+{
+    uint32_t slot;
+    if (!freeSlots.empty()) {
+        slot = freeSlots.back();
+        freeSlots.pop_back();
+    } else {
+        slot = (uint32_t)slots.size();
+        slots.push_back(Slot());
+    }
+
+    slots[slot].dense = (uint32_t)from.size();
+
+    depart.push_back(departTick);
+    arrive.push_back(arriveTick);
+    speed.push_back(unitSpeed);
+    from.push_back(fromId);
+    to.push_back(toId);
+    owner.push_back(who);
+    members.push_back(1);
+    stride.push_back(0);
+    denseToSlot.push_back(slot);
+
+    return { slot, slots[slot].generation };
+}
+
+void UnitPool::removeAt(size_t i)
+{
+    if (i >= from.size()) return;
+
+    uint32_t slot = denseToSlot[i];
+    size_t last = from.size() - 1;
+
+    if (i != last) {
+        depart[i] = depart[last];
+        arrive[i] = arrive[last];
+        speed[i] = speed[last];
+        from[i] = from[last];
+        to[i] = to[last];
+        owner[i] = owner[last];
+        members[i] = members[last];
+        stride[i] = stride[last];
+        denseToSlot[i] = denseToSlot[last];
+        slots[denseToSlot[i]].dense = (uint32_t)i;
+    }
+
+    depart.pop_back();
+    arrive.pop_back();
+    speed.pop_back();
+    from.pop_back();
+    to.pop_back();
+    owner.pop_back();
+    members.pop_back();
+    stride.pop_back();
+    denseToSlot.pop_back();
+
+    slots[slot].generation++;
+    freeSlots.push_back(slot);
+}
+
+void UnitPool::removeSorted(const std::vector<uint32_t>& positions)
+{
+    // back to front: whatever gets swapped down is past every position
+    // already removed and before none still pending, so it is never one
+    // of them
+    for (size_t k = positions.size(); k-- > 0;)
+        removeAt(positions[k]);
+}
+
+void UnitPool::remove(UnitHandle h)
+{
+    int i = indexOf(h);
+    if (i >= 0) removeAt((size_t)i);
+}
+
+int UnitPool::indexOf(UnitHandle h) const
+{
+    if (h.index >= slots.size()) return -1;
+    if (slots[h.index].generation != h.generation) return -1;
+    return (int)slots[h.index].dense;
+}
+
+UnitHandle UnitPool::handleAt(size_t i) const
+{
+    uint32_t slot = denseToSlot[i];
+    return { slot, slots[slot].generation };
+}
+
+void UnitPool::assign(size_t entries, const int* departIn, const int* arriveIn, const float* speedIn,
+                      const int* fromIn, const int* toIn, const Owner* ownerIn,
+                      const uint64_t* membersIn, const int* strideIn)
+{
+    clear();
+
+    depart.assign(departIn, departIn + entries);
+    arrive.assign(arriveIn, arriveIn + entries);
+    speed.assign(speedIn, speedIn + entries);
+    from.assign(fromIn, fromIn + entries);
+    to.assign(toIn, toIn + entries);
+    owner.assign(ownerIn, ownerIn + entries);
+    members.assign(membersIn, membersIn + entries);
+    stride.assign(strideIn, strideIn + entries);
+
+    denseToSlot.resize(entries);
+    for (size_t i = 0; i < entries; ++i) {
+        uint32_t slot;
+        if (!freeSlots.empty()) {
+            slot = freeSlots.back();
+            freeSlots.pop_back();
+        } else {
+            slot = (uint32_t)slots.size();
+            slots.push_back(Slot());
+        }
+        slots[slot].dense = (uint32_t)i;
+        denseToSlot[i] = slot;
+    }
+
+    // so the clear() of the next assign has room to free every slot
+    freeSlots.reserve(slots.size());
+}
+
+void UnitPool::reserve(size_t n)
+{
+    depart.reserve(n);
+    arrive.reserve(n);
+    speed.reserve(n);
+    from.reserve(n);
+    to.reserve(n);
+    owner.reserve(n);
+    members.reserve(n);
+    stride.reserve(n);
+    denseToSlot.reserve(n);
+    slots.reserve(n);
+    freeSlots.reserve(n);
+}
+
+void UnitPool::clear()
+{
+    resets++;
+    for (uint32_t slot : denseToSlot) {
+        slots[slot].generation++;
+        freeSlots.push_back(slot);
+    }
+
+    depart.clear();
+    arrive.clear();
+    speed.clear();
+    from.clear();
+    to.clear();
+    owner.clear();
+    members.clear();
+    stride.clear();
+    denseToSlot.clear();
+}
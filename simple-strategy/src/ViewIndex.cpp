@@ -0,0 +1,170 @@
+#include "ViewIndex.h"
+#include <algorithm>
+#include <cmath>
+
+void ViewIndex::rebuildRoads(const GlobalState& game)
+{
+    const std::vector<Road>& roads = game.roads;
+
+    cols = rows = 0;
+    cellStart.clear();
+    items.clear();
+    seen.assign(roads.size(), query);
+    roadByEnds.clear();
+    roadUnits.assign(roads.size(), std::vector<UnitHandle>());
+    unitsTick = -1; // refile on the next sync
+
+    if (game.nodes.empty()) return;
+
+    float minX = game.nodes[0].x, maxX = minX;
+    float minY = game.nodes[0].y, maxY = minY;
+    for (const Node& n : game.nodes) {
+        minX = std::min(minX, n.x); maxX = std::max(maxX, n.x);
+        minY = std::min(minY, n.y); maxY = std::max(maxY, n.y);
+    }
+
+    // a few node cells wide, and about as many cells as roads
+    cellSize = std::max(game.grid.cellSize * 4.0f, 1.0f);
+    float area = (maxX - minX + cellSize) * (maxY - minY + cellSize);
+    float maxCells = (float)roads.size() + 64.0f;
+    if (area / (cellSize * cellSize) > maxCells)
+        cellSize = std::sqrt(area / maxCells);
+
+    originX = minX;
+    originY = minY;
+    cols = (int)((maxX - minX) / cellSize) + 1;
+    rows = (int)((maxY - minY) / cellSize) + 1;
+
+    // counting sort of road indices into the cells each road crosses,
+    // walked from a to b one cell boundary at a time. A long diagonal
+    // road gets about cols + rows cells instead of cols * rows.
+    auto forCells = [&](const Road& r, auto fn) {
+        const Node& a = game.nodes[r.a];
+        const Node& b = game.nodes[r.b];
+        int cx = cellX(a.x), cy = cellY(a.y);
+        int ex = cellX(b.x), ey = cellY(b.y);
+        int stepX = ex > cx ? 1 : -1, stepY = ey > cy ? 1 : -1;
+
+        // distance along the road, as a fraction of it, to the next
+        // vertical and horizontal cell boundary, and between boundaries
+        float dx = b.x - a.x, dy = b.y - a.y;
+        float edgeX = originX + (cx + (stepX > 0 ? 1 : 0)) * cellSize;
+        float edgeY = originY + (cy + (stepY > 0 ? 1 : 0)) * cellSize;
+        float nextX = dx != 0.0f ? (edgeX - a.x) / dx : INFINITY;
+        float nextY = dy != 0.0f ? (edgeY - a.y) / dy : INFINITY;
+        float deltaX = dx != 0.0f ? cellSize / std::fabs(dx) : INFINITY;
+        float deltaY = dy != 0.0f ? cellSize / std::fabs(dy) : INFINITY;
+
+        // exactly one step per boundary between the end cells, so rounding
+        // cannot walk past b or loop
+        fn(cy * cols + cx);
+        for (int left = std::abs(ex - cx) + std::abs(ey - cy); left > 0; --left) {
+            if (cy == ey || (cx != ex && nextX < nextY)) {
+                cx += stepX;
+                nextX += deltaX;
+            } else {
+                cy += stepY;
+                nextY += deltaY;
+            }
+            fn(cy * cols + cx);
+        }
+    };
+
+    cellStart.assign((size_t)cols * rows + 1, 0);
+    for (const Road& r : roads)
+        forCells(r, [&](int c) { cellStart[c + 1]++; });
+    for (size_t c = 1; c < cellStart.size(); ++c)
+        cellStart[c] += cellStart[c - 1];
+
+    items.resize(cellStart.back());
+    std::vector<int> fill(cellStart.begin(), cellStart.end() - 1);
+    for (size_t i = 0; i < roads.size(); ++i)
+        forCells(roads[i], [&](int c) { items[fill[c]++] = (int)i; });
+
+    roadByEnds.reserve(roads.size() * 2);
+    for (size_t i = 0; i < roads.size(); ++i) {
+        uint32_t a = (uint32_t)roads[i].a, b = (uint32_t)roads[i].b;
+        roadByEnds[(uint64_t)a << 32 | b] = (int)i;
+        roadByEnds[(uint64_t)b << 32 | a] = (int)i;
+    }
+}
+
+int ViewIndex::cellX(float x) const
+{
+    int c = (int)std::floor((x - originX) / cellSize);
+    return std::max(0, std::min(cols - 1, c));
+}
+
+int ViewIndex::cellY(float y) const
+{
+    int c = (int)std::floor((y - originY) / cellSize);
+    return std::max(0, std::min(rows - 1, c));
+}
+
+void ViewIndex::queryRoads(float minX, float minY, float maxX, float maxY, std::vector<int>& out)
+{
+    if (cols == 0) return;
+
+    if (++query == 0) {
+        // wrapped; nothing may look seen by this query
+        std::fill(seen.begin(), seen.end(), 0u);
+        query = 1;
+    }
+
+    int x0 = cellX(minX), x1 = cellX(maxX);
+    int y0 = cellY(minY), y1 = cellY(maxY);
+    for (int cy = y0; cy <= y1; ++cy) {
+        for (int cx = x0; cx <= x1; ++cx) {
+            int c = cy * cols + cx;
+            for (int k = cellStart[c]; k < cellStart[c + 1]; ++k) {
+                int road = items[k];
+                if (seen[road] == query) continue;
+                seen[road] = query;
+                out.push_back(road);
+            }
+        }
+    }
+}
+
+void ViewIndex::fileUnit(const UnitPool& units, UnitHandle h, int from, int to)
+{
+    auto it = roadByEnds.find((uint64_t)(uint32_t)from << 32 | (uint32_t)to);
+    if (it == roadByEnds.end()) return;
+
+    std::vector<UnitHandle>& list = roadUnits[it->second];
+    if (list.size() == list.capacity()) {
+        // about to grow: drop the handles of units that landed first, so
+        // roads off screen do not collect them without bound
+        size_t kept = 0;
+        for (UnitHandle k : list)
+            if (units.indexOf(k) >= 0) list[kept++] = k;
+        list.resize(kept);
+    }
+    list.push_back(h);
+}
+
+void ViewIndex::refileUnits(const GlobalState& game)
+{
+    for (std::vector<UnitHandle>& list : roadUnits)
+        list.clear();
+
+    const UnitPool& u = game.units;
+    for (size_t i = 0; i < u.size(); ++i)
+        fileUnit(u, u.handleAt(i), u.from[i], u.to[i]);
+}
+
+void ViewIndex::syncUnits(const GlobalState& game)
+{
+    if (game.tick == unitsTick && game.units.resets == unitsResets) return;
+
+    // one tick on: its sends are all that is new; joining a run adds nothing
+    if (game.tick == unitsTick + 1 && game.units.resets == unitsResets) {
+        for (const SentUnit& s : game.sent)
+            if (!s.joined) fileUnit(game.units, s.unit, s.from, s.to);
+    } else {
+        refileUnits(game);
+    }
+
+    unitsTick = game.tick;
+    unitsResets = game.units.resets;
+}
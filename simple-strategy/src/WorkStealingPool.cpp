@@ -0,0 +1,119 @@
+#include "WorkStealingPool.h"
+
+WorkStealingPool::WorkStealingPool(int threads)
+{
+    if (threads <= 0) threads = (int)std::thread::hardware_concurrency();
+    if (threads <= 0) threads = 1;
+
+    for (int i = 0; i < threads; ++i)
+        queues.push_back(std::unique_ptr<Queue>(new Queue()));
+
+    // the caller of run() acts as worker 0
+    for (int i = 1; i < threads; ++i)
+        this->threads.emplace_back(&WorkStealingPool::workerLoop, this, i);
+}
+
+WorkStealingPool::~WorkStealingPool()
+{
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        stopping = true;
+    }
+    wake.notify_all();
+
+    for (std::thread& t : threads)
+        t.join();
+}
+
+void WorkStealingPool::run(size_t count, const std::function<void(size_t, int)>& fn)
+{
+    if (count == 0) return;
+
+    std::unique_lock<std::mutex> guard(lock);
+
+    size_t workers = queues.size();
+    for (size_t w = 0; w < workers; ++w) {
+        std::lock_guard<std::mutex> qguard(queues[w]->lock);
+        for (size_t i = w * count / workers; i < (w + 1) * count / workers; ++i)
+            queues[w]->items.push_back(i);
+    }
+
+    remaining = count;
+    job = &fn;
+    generation++;
+    guard.unlock();
+    wake.notify_all();
+
+    drain(0, fn);
+
+    // workers that picked up this batch must be out of drain() before the
+    // job goes out of scope
+    guard.lock();
+    done.wait(guard, [this] { return remaining == 0 && busy == 0; });
+    job = nullptr;
+}
+
+void WorkStealingPool::workerLoop(int self)
+{
+    uint64_t seen = 0;
+
+    for (;;) {
+        const std::function<void(size_t, int)>* fn;
+        {
+            std::unique_lock<std::mutex> guard(lock);
+            wake.wait(guard, [&] { return stopping || generation != seen; });
+            if (stopping) return;
+
+            seen = generation;
+            fn = job;
+            if (!fn) continue;
+            busy++;
+        }
+
+        drain(self, *fn);
+
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            busy--;
+        }
+        done.notify_all();
+    }
+}
+
+void WorkStealingPool::drain(int self, const std::function<void(size_t, int)>& fn)
+{
+    size_t item;
+    while (takeWork(self, item)) {
+        fn(item, self);
+        if (remaining.fetch_sub(1) == 1) {
+            std::lock_guard<std::mutex> guard(lock);
+            done.notify_all();
+        }
+    }
+}
+
+bool WorkStealingPool::takeWork(int self, size_t& item)
+{
+    {
+        Queue& own = *queues[self];
+        std::lock_guard<std::mutex> guard(own.lock);
+        if (!own.items.empty()) {
+            item = own.items.back();
+            own.items.pop_back();
+            return true;
+        }
+    }
+
+    int n = (int)queues.size();
+    for (int k = 1; k < n; ++k) {
+        Queue& victim = *queues[(self + k) % n];
+        std::lock_guard<std::mutex> guard(victim.lock);
+        if (!victim.items.empty()) {
+            item = victim.items.front();
+            victim.items.pop_front();
+            return true;
+        }
+    }
+
+    return false;
+}
@@ -0,0 +1,93 @@
+// Bot arena: the MCTS bot plays blue against the budgeted AI on red, on a
+// generated map, and reports the result and the search throughput.
+#include "EnemyAI.h"
+#include "MctsBot.h"
+#include "WorkStealingPool.h"
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+struct ArenaConfig {
+    int layers = 4;
+    int width = 4;
+    uint32_t seed = 1;
+    int maxTicks = 30 * 60 * 3;
+    int threads = 0;
+    MctsConfig mcts;
+};
+
+static void usage()
+{
+    std::fprintf(stderr,
+        "usage: strategy_arena [options]\n"
+        "  --layers N        layers per side (default 4)\n"
+        "  --width N         nodes per layer (default 4)\n"
+        "  --seed N          map seed, also seeds the search (default 1)\n"
+        "  --ticks N         tick limit (default 5400)\n"
+        "  --threads N       search threads, 0 for all cores (default 0)\n"
+        "  --iterations N    rollouts per decision (default 2000)\n"
+        "  --rollout N       rollout length in ticks (default 300)\n"
+        "  --decision N      ticks between decisions (default 30)\n");
+}
+
+int main(int argc, char** argv)
+{
+    ArenaConfig cfg;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if (arg == "--layers" && hasValue)           cfg.layers = std::atoi(argv[++i]);
+        else if (arg == "--width" && hasValue)       cfg.width = std::atoi(argv[++i]);
+        else if (arg == "--seed" && hasValue)        cfg.seed = (uint32_t)std::strtoul(argv[++i], nullptr, 10);
+        else if (arg == "--ticks" && hasValue)       cfg.maxTicks = std::atoi(argv[++i]);
+        else if (arg == "--threads" && hasValue)     cfg.threads = std::atoi(argv[++i]);
+        else if (arg == "--iterations" && hasValue)  cfg.mcts.iterations = std::atoi(argv[++i]);
+        else if (arg == "--rollout" && hasValue)     cfg.mcts.rolloutTicks = std::atoi(argv[++i]);
+        else if (arg == "--decision" && hasValue)    cfg.mcts.decisionTicks = std::atoi(argv[++i]);
+        else {
+            usage();
+            return arg == "--help" ? 0 : 1;
+        }
+    }
+    if (cfg.mcts.decisionTicks < 1) cfg.mcts.decisionTicks = 1;
+    cfg.mcts.seed = cfg.seed;
+
+    MapData map = generateMap(cfg.layers, cfg.width, cfg.seed);
+    GlobalState game;
+    game.load(map.view());
+    game.submit({ CommandType::Start });
+
+    WorkStealingPool pool(cfg.threads);
+    MctsBot bot(Owner::Player, pool, cfg.mcts);
+
+    // full passes keep the opponent deterministic
+    AIConfig aiConfig;
+    aiConfig.budgetUs = 0;
+    EnemyAI ai(Owner::Enemy, aiConfig);
+
+    int decisions = 0, roads = 0;
+    while (game.tick < cfg.maxTicks && !game.gameOver) {
+        if (game.gameStarted && game.tick % cfg.mcts.decisionTicks == 0) {
+            Command cmd;
+            if (bot.think(game, cmd)) {
+                game.submit(cmd);
+                roads++;
+            }
+            decisions++;
+        }
+        ai.update(game);
+        game.step();
+    }
+
+    const char* result = !game.gameOver ? "time limit"
+        : game.winner == Owner::Player ? "MCTS (blue) won" : "AI (red) won";
+    std::printf("%d nodes, %d threads: %s at tick %d\n",
+                (int)game.nodes.size(), pool.threadCount(), result, game.tick);
+
+    const MctsStats& s = bot.totalStats();
+    std::printf("%d decisions, %d roads, %lld rollouts in %.2f s: %.0f rollouts/s, %.0f ticks/s\n",
+                decisions, roads, s.rollouts, s.seconds, s.rolloutsPerSecond(), s.ticksPerSecond());
+    return 0;
+}
@@ -0,0 +1,448 @@
+// Headless throughput benchmark: runs matches on synthetic maps of
+// increasing size as fast as the simulation allows and reports per-tick
+// costs. Use --format json or csv to track results between commits.
+#include "EnemyAI.h"
+#include "GlobalState.h"
+#include "Ruleset.h"
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
+#include <sys/resource.h>
+
+// every heap allocation in the process goes through here: plain, array,
+// nothrow and over-aligned forms of new all count, and every delete
+// releases through release() so no path pairs new with a bare free
+static std::atomic<unsigned long long> allocCount(0);
+
+static void* allocate(std::size_t size, std::size_t align)
+{
+    allocCount.fetch_add(1, std::memory_order_relaxed);
+    if (size == 0) size = 1;
+    if (align <= alignof(std::max_align_t)) return std::malloc(size);
+    // aligned_alloc wants a multiple of the alignment
+    return std::aligned_alloc(align, (size + align - 1) / align * align);
+}
+
+__attribute__((noinline)) static void release(void* p) noexcept
+{
+    std::free(p);
+}
+
+static void* allocateOrThrow(std::size_t size, std::size_t align)
+{
+    if (void* p = allocate(size, align)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size) { return allocateOrThrow(size, 0); }
+void* operator new[](std::size_t size) { return allocateOrThrow(size, 0); }
+void* operator new(std::size_t size, std::align_val_t a) { return allocateOrThrow(size, (std::size_t)a); }
+void* operator new[](std::size_t size, std::align_val_t a) { return allocateOrThrow(size, (std::size_t)a); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept { return allocate(size, 0); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return allocate(size, 0); }
+void* operator new(std::size_t size, std::align_val_t a, const std::nothrow_t&) noexcept { return allocate(size, (std::size_t)a); }
+void* operator new[](std::size_t size, std::align_val_t a, const std::nothrow_t&) noexcept { return allocate(size, (std::size_t)a); }
+
+void operator delete(void* p) noexcept { release(p); }
+void operator delete[](void* p) noexcept { release(p); }
+void operator delete(void* p, std::size_t) noexcept { release(p); }
+void operator delete[](void* p, std::size_t) noexcept { release(p); }
+void operator delete(void* p, std::align_val_t) noexcept { release(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { release(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { release(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { release(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { release(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { release(p); }
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept { release(p); }
+void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept { release(p); }
+
+struct BenchConfig {
+    int matches = 3;
+    int maxTicks = 3000;
+    uint32_t seed = 1;
+    std::vector<int> widths = { 4, 40, 400, 1600 };
+    int layers = 6;
+    std::string mapPath;
+    std::string format = "table";
+    int snapshotUnits = 0; // > 0: time snapshot write/restore instead
+    int aiBudgetUs = -1;   // >= 0: an AI plays each side with this budget
+    std::string tracePath; // profile the phases, write the last match's trace
+    GameMode mode = GameMode::Standard;
+    bool runtimeRules = false; // GlobalState::specialize off
+    bool streams = false;  // Rules::unitStreams
+    float sendInterval = 0.0f; // > 0: overrides Rules::sendInterval
+    float unitSpeed = 0.0f;    // > 0: overrides Rules::unitSpeed
+};
+
+struct BenchResult {
+    std::string name;
+    int nodes = 0;
+    int matches = 0;
+    long long ticks = 0;
+    long long unitTicks = 0; // sum over ticks of units alive
+    long long entryTicks = 0; // same for unit pool entries (runs)
+    double seconds = 0.0;
+    unsigned long long allocs = 0;
+    int finished = 0;        // matches that ended with a winner
+    long peakRssKb = 0;
+    double aiSeconds = 0.0;  // inside EnemyAI::update, both sides
+    double aiMaxUs = 0.0;    // longest single update
+    int roads = 0;           // roads the AIs built
+    double phaseMs[(int)Phase::Count] = {}; // summed over all ticks
+    double phasePeakMs[(int)Phase::Count] = {};
+};
+
+static long peakRssKb()
+{
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    return ru.ru_maxrss;
+}
+
+static Rules benchRules(const BenchConfig& cfg)
+{
+    Rules rules = rulesFor(cfg.mode);
+    if (cfg.streams) rules.unitStreams = true;
+    if (cfg.sendInterval > 0.0f) rules.sendInterval = cfg.sendInterval;
+    if (cfg.unitSpeed > 0.0f) rules.unitSpeed = cfg.unitSpeed;
+    return rules;
+}
+
+static void runMatch(const MapView& map, const BenchConfig& cfg, BenchResult& r, Profiler* profiler)
+{
+    GlobalState game;
+    game.load(map);
+    game.profiler = profiler;
+    game.rules = benchRules(cfg);
+    game.specialize = !cfg.runtimeRules;
+    game.submit({ CommandType::Start });
+
+    unsigned long long allocsBefore = allocCount.load();
+    auto start = std::chrono::steady_clock::now();
+
+    AIConfig aiConfig;
+    aiConfig.budgetUs = cfg.aiBudgetUs;
+    EnemyAI ai[2] = { EnemyAI(Owner::Player, aiConfig), EnemyAI(Owner::Enemy, aiConfig) };
+    size_t startRoads = game.roads.size();
+
+    int ticks = 0;
+    long long unitTicks = 0, entryTicks = 0;
+    while (ticks < cfg.maxTicks && !game.gameOver) {
+        if (cfg.aiBudgetUs >= 0) {
+            for (EnemyAI& a : ai) {
+                auto t0 = std::chrono::steady_clock::now();
+                a.update(game);
+                double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count();
+                r.aiSeconds += us * 1e-6;
+                if (us > r.aiMaxUs) r.aiMaxUs = us;
+            }
+        }
+        game.step();
+        unitTicks += (long long)game.unitsInFlight();
+        entryTicks += (long long)game.units.size();
+        ticks++;
+
+        if (profiler) {
+            // a tick is a frame here
+            profiler->endFrame();
+            for (int p = 0; p < (int)Phase::Count; ++p) {
+                double ms = profiler->lastFrame((Phase)p);
+                r.phaseMs[p] += ms;
+                if (ms > r.phasePeakMs[p]) r.phasePeakMs[p] = ms;
+            }
+        }
+    }
+
+    auto end = std::chrono::steady_clock::now();
+
+    r.seconds += std::chrono::duration<double>(end - start).count();
+    r.allocs += allocCount.load() - allocsBefore;
+    r.ticks += ticks;
+    r.unitTicks += unitTicks;
+    r.entryTicks += entryTicks;
+    r.matches++;
+    r.roads += (int)(game.roads.size() - startRoads);
+    if (game.gameOver) r.finished++;
+}
+
+static BenchResult runSize(const std::string& name, const MapView& map, const BenchConfig& cfg,
+                           Profiler* profiler)
+{
+    BenchResult r;
+    r.name = name;
+    r.nodes = (int)map.nodeCount;
+
+    for (int m = 0; m < cfg.matches; ++m) {
+        // the exported trace is the last match only
+        if (profiler) profiler->clearTrace();
+        runMatch(map, cfg, r, profiler);
+    }
+
+    r.peakRssKb = peakRssKb();
+    return r;
+}
+
+// Fills the largest synthetic map with units on its roads and times
+// writing a snapshot, saving it, and restoring it from the mapped file.
+static int runSnapshotBench(const BenchConfig& cfg)
+{
+    int width = cfg.widths.empty() ? 1600 : cfg.widths.back();
+    MapData map = generateMap(cfg.layers, width, cfg.seed);
+
+    GlobalState game;
+    game.load(map.view());
+    game.submit({ CommandType::Start });
+    game.step();
+
+    for (int i = 0; i < cfg.snapshotUnits; ++i) {
+        const Road& r = game.roads[i % game.roads.size()];
+        game.spawnUnit(r.a, r.b, game.nodes[r.a].owner);
+    }
+
+    const char* path = "bench_snapshot.bin";
+    const int reps = 20;
+    std::vector<uint8_t> bytes;
+    std::string error;
+
+    auto time = [](auto fn) {
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    };
+
+    game.snapshot(bytes);
+    double writeMs = time([&] { for (int i = 0; i < reps; ++i) game.snapshot(bytes); }) / reps;
+
+    bool ok = false;
+    double saveMs = time([&] { ok = saveSnapshot(path, game, error); });
+    if (!ok) {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+
+    GlobalState copy;
+    double openMs = 0.0, restoreMs = 0.0;
+    unsigned long long allocs = 0;
+    for (int i = 0; i < reps; ++i) {
+        SnapshotFile file;
+        openMs += time([&] { ok = file.open(path, error); });
+        if (!ok) {
+            std::fprintf(stderr, "%s\n", error.c_str());
+            std::remove(path);
+            return 1;
+        }
+
+        unsigned long long before = allocCount.load();
+        restoreMs += time([&] { copy.restore(file.view()); });
+        if (i > 0) allocs += allocCount.load() - before;
+    }
+    std::remove(path);
+
+    bool same = copy.stateHash() == game.stateHash();
+    std::printf("snapshot: %d nodes, %zu units, %.1f MB\n",
+                (int)game.nodes.size(), game.unitsInFlight(), bytes.size() / 1048576.0);
+    std::printf("  write %.2f ms, save %.2f ms, open+check %.2f ms, restore %.2f ms "
+                "(%.1f allocs after the first), %s\n",
+                writeMs, saveMs, openMs / reps, restoreMs / reps,
+                reps > 1 ? (double)allocs / (reps - 1) : 0.0,
+                same ? "hash matches" : "HASH DIFFERS");
+    return same ? 0 : 1;
+}
+
+static void printResult(const BenchResult& r, const std::string& format)
+{
+    double ns = r.seconds * 1e9;
+    double ticksPerSec = r.seconds > 0.0 ? r.ticks / r.seconds : 0.0;
+    double nsPerNode = r.ticks ? ns / ((double)r.ticks * r.nodes) : 0.0;
+    double nsPerUnit = r.unitTicks ? ns / (double)r.unitTicks : 0.0;
+    double allocsPerTick = r.ticks ? (double)r.allocs / r.ticks : 0.0;
+    double unitsAvg = r.ticks ? (double)r.unitTicks / r.ticks : 0.0;
+
+    if (format == "json") {
+        std::printf("{\"map\":\"%s\",\"nodes\":%d,\"matches\":%d,\"finished\":%d,"
+                    "\"ticks\":%lld,\"units_avg\":%.1f,\"ticks_per_sec\":%.1f,"
+                    "\"ns_per_node_tick\":%.3f,\"ns_per_unit_tick\":%.3f,"
+                    "\"allocs_per_tick\":%.3f,\"peak_rss_kb\":%ld}\n",
+                    r.name.c_str(), r.nodes, r.matches, r.finished, r.ticks, unitsAvg,
+                    ticksPerSec, nsPerNode, nsPerUnit, allocsPerTick, r.peakRssKb);
+    } else if (format == "csv") {
+        std::printf("%s,%d,%d,%d,%lld,%.1f,%.1f,%.3f,%.3f,%.3f,%ld\n",
+                    r.name.c_str(), r.nodes, r.matches, r.finished, r.ticks, unitsAvg,
+                    ticksPerSec, nsPerNode, nsPerUnit, allocsPerTick, r.peakRssKb);
+    } else {
+        std::printf("%-14s %8d %5d/%-3d %9lld %10.0f %12.1f %10.2f %10.2f %9.2f %10ld\n",
+                    r.name.c_str(), r.nodes, r.finished, r.matches, r.ticks, unitsAvg,
+                    ticksPerSec, nsPerNode, nsPerUnit, allocsPerTick, r.peakRssKb);
+        if (r.entryTicks != r.unitTicks)
+            std::printf("%-14s streams: %.0f runs avg, %.1f units per run\n", "",
+                        (double)r.entryTicks / r.ticks, (double)r.unitTicks / r.entryTicks);
+        if (r.aiSeconds > 0.0)
+            std::printf("%-14s ai: %d roads, %.1f us mean, %.1f us max per update\n", "",
+                        r.roads, r.aiSeconds * 1e6 / (2.0 * r.ticks), r.aiMaxUs);
+        if (r.phaseMs[(int)Phase::Production] > 0.0) {
+            std::printf("%-14s us/tick avg/max:", "");
+            for (int p = (int)Phase::Commands; p <= (int)Phase::Arrivals; ++p)
+                std::printf(" %s %.1f/%.0f", phaseName((Phase)p),
+                            r.phaseMs[p] * 1e3 / r.ticks, r.phasePeakMs[p] * 1e3);
+            std::printf("\n");
+        }
+    }
+    std::fflush(stdout);
+}
+
+static int writeTrace(const Profiler* profiler, const std::string& path)
+{
+    if (!profiler) return 0;
+
+    std::string error;
+    if (!profiler->exportTrace(path, error)) {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+    return 0;
+}
+
+static void printHeader(const std::string& format)
+{
+    if (format == "csv") {
+        std::printf("map,nodes,matches,finished,ticks,units_avg,ticks_per_sec,"
+                    "ns_per_node_tick,ns_per_unit_tick,allocs_per_tick,peak_rss_kb\n");
+    } else if (format == "table") {
+        std::printf("%-14s %8s %9s %9s %10s %12s %10s %10s %9s %10s\n",
+                    "map", "nodes", "won/runs", "ticks", "units avg", "ticks/s",
+                    "ns/node", "ns/unit", "alloc/t", "rss KB");
+    }
+}
+
+static void usage()
+{
+    std::fprintf(stderr,
+        "usage: strategy_bench [options]\n"
+        "  --matches N       matches per map (default 3)\n"
+        "  --ticks N         tick limit per match (default 3000)\n"
+        "  --layers N        layers per side of synthetic maps (default 6)\n"
+        "  --widths a,b,...  nodes per layer of each synthetic map\n"
+        "  --seed N          map generator seed (default 1)\n"
+        "  --map FILE        benchmark this map instead of synthetic ones\n"
+        "  --format F        table, json (one object per line) or csv\n"
+        "  --trace FILE      time each phase of step(), print the breakdown and\n"
+        "                    write the last match as Chrome trace JSON\n"
+        "  --ai US           an AI plays each side, planning US microseconds\n"
+        "                    per update (0: a full pass each update)\n"
+        "  --snapshot N      time snapshot write/restore of N units on the\n"
+        "                    widest map instead of running matches\n"
+        "  --mode M          standard, blitz or siege rules (Ruleset.h)\n"
+        "  --runtime-rules   read the rules at run time, not from the mode's\n"
+        "                    compiled ruleset\n"
+        "  --streams         units on a road travel as runs (Rules::unitStreams)\n"
+        "  --send S          seconds between sends from a node\n"
+        "  --speed V         unit speed, fraction of a road per second\n");
+}
+
+// an override must be a positive number; 0 is the "no override" default
+static bool parseRule(const char* text, float& out)
+{
+    char* end;
+    out = std::strtof(text, &end);
+    return end != text && *end == '\0' && out > 0.0f;
+}
+
+int main(int argc, char** argv)
+{
+    BenchConfig cfg;
+    bool ok = true;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if (arg == "--matches" && hasValue)      cfg.matches = std::atoi(argv[++i]);
+        else if (arg == "--ticks" && hasValue)   cfg.maxTicks = std::atoi(argv[++i]);
+        else if (arg == "--layers" && hasValue)  cfg.layers = std::atoi(argv[++i]);
+        else if (arg == "--seed" && hasValue)    cfg.seed = (uint32_t)std::strtoul(argv[++i], nullptr, 10);
+        else if (arg == "--map" && hasValue)     cfg.mapPath = argv[++i];
+        else if (arg == "--format" && hasValue)  cfg.format = argv[++i];
+        else if (arg == "--snapshot" && hasValue) cfg.snapshotUnits = std::atoi(argv[++i]);
+        else if (arg == "--ai" && hasValue)      cfg.aiBudgetUs = std::atoi(argv[++i]);
+        else if (arg == "--trace" && hasValue)   cfg.tracePath = argv[++i];
+        else if (arg == "--runtime-rules")       cfg.runtimeRules = true;
+        else if (arg == "--streams")             cfg.streams = true;
+        else if (arg == "--send" && hasValue)    ok &= parseRule(argv[++i], cfg.sendInterval);
+        else if (arg == "--speed" && hasValue)   ok &= parseRule(argv[++i], cfg.unitSpeed);
+        else if (arg == "--widths" && hasValue) {
+            cfg.widths.clear();
+            for (char* p = argv[++i]; *p;) {
+                char* end;
+                long w = std::strtol(p, &end, 10);
+                if (end == p) break;
+                cfg.widths.push_back((int)w);
+                p = *end == ',' ? end + 1 : end;
+            }
+        } else if (arg == "--mode" && hasValue) {
+            if (!parseGameMode(argv[++i], cfg.mode)) {
+                usage();
+                return 1;
+            }
+        } else {
+            usage();
+            return arg == "--help" ? 0 : 1;
+        }
+    }
+
+    if (!ok || !benchRules(cfg).valid()) {
+        std::fprintf(stderr, "--send and --speed must be positive and finite\n");
+        return 1;
+    }
+
+    if (cfg.format != "table" && cfg.format != "json" && cfg.format != "csv") {
+        usage();
+        return 1;
+    }
+
+    if (cfg.snapshotUnits > 0)
+        return runSnapshotBench(cfg);
+
+    std::unique_ptr<Profiler> profiler;
+    if (!cfg.tracePath.empty()) profiler.reset(new Profiler());
+
+    printHeader(cfg.format);
+
+    if (!cfg.mapPath.empty()) {
+        std::string error;
+        MapFile file;
+        MapData data;
+        MapView view;
+
+        if (isBinaryMap(cfg.mapPath)) {
+            if (!file.open(cfg.mapPath, error)) {
+                std::fprintf(stderr, "%s\n", error.c_str());
+                return 1;
+            }
+            view = file.view();
+        } else {
+            if (!loadMapText(cfg.mapPath, data, error)) {
+                std::fprintf(stderr, "%s\n", error.c_str());
+                return 1;
+            }
+            view = data.view();
+        }
+
+        printResult(runSize(cfg.mapPath, view, cfg, profiler.get()), cfg.format);
+        return writeTrace(profiler.get(), cfg.tracePath);
+    }
+
+    for (int width : cfg.widths) {
+        MapData map = generateMap(cfg.layers, width, cfg.seed);
+        std::string name = "gen-" + std::to_string(cfg.layers) + "x" + std::to_string(width);
+        printResult(runSize(name, map.view(), cfg, profiler.get()), cfg.format);
+    }
+
+    return writeTrace(profiler.get(), cfg.tracePath);
+}
@@ -0,0 +1,204 @@
+// Lockstep load test: opens two localhost clients per match, lets the AI
+// play both sides through the server, and checks every client's state
+// hash against the server's. Watchers follow the spectator stream and
+// check each keyframe against the state their deltas built.
+#include "Client.h"
+#include "EnemyAI.h"
+#include "Server.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <poll.h>
+
+struct LoadConfig {
+    int matches = 200;
+    int watchers = 0; // per match
+    double seconds = 10.0;
+    std::string host = "127.0.0.1";
+    int port = 0; // 0: run a server in this process
+    ServerConfig server;
+};
+
+struct Player {
+    GlobalState game;
+    LockstepClient client{ game };
+    EnemyAI ai;
+    bool failed = false;
+};
+
+struct Watcher {
+    GlobalState view;
+    SpectatorClient client{ view };
+    bool failed = false;
+};
+
+static void usage()
+{
+    std::fprintf(stderr,
+        "usage: strategy_loadtest [options]\n"
+        "  --matches N       concurrent matches, two clients each (default 200)\n"
+        "  --watchers N      spectators per match (default 0)\n"
+        "  --seconds S       how long to play (default 10)\n"
+        "  --host H          server host (default 127.0.0.1)\n"
+        "  --port N          server port; 0 starts one in-process (default 0)\n"
+        "  --layers N        map layers per side, in-process server (default 4)\n"
+        "  --width N         nodes per layer, in-process server (default 4)\n");
+}
+
+int main(int argc, char** argv)
+{
+    LoadConfig cfg;
+    cfg.server.port = 0;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if (arg == "--matches" && hasValue)      cfg.matches = std::atoi(argv[++i]);
+        else if (arg == "--watchers" && hasValue) cfg.watchers = std::atoi(argv[++i]);
+        else if (arg == "--seconds" && hasValue) cfg.seconds = std::atof(argv[++i]);
+        else if (arg == "--host" && hasValue)    cfg.host = argv[++i];
+        else if (arg == "--port" && hasValue)    cfg.port = std::atoi(argv[++i]);
+        else if (arg == "--layers" && hasValue)  cfg.server.layers = std::atoi(argv[++i]);
+        else if (arg == "--width" && hasValue)   cfg.server.width = std::atoi(argv[++i]);
+        else {
+            usage();
+            return arg == "--help" ? 0 : 1;
+        }
+    }
+
+    std::string error;
+    std::unique_ptr<LockstepServer> server;
+    std::thread serverThread;
+    uint16_t port = (uint16_t)cfg.port;
+
+    if (cfg.port == 0) {
+        server.reset(new LockstepServer(cfg.server));
+        if (!server->start(error)) {
+            std::fprintf(stderr, "%s\n", error.c_str());
+            return 1;
+        }
+        port = server->port();
+        serverThread = std::thread([&] { server->run(); });
+    }
+
+    AIConfig aiConfig;
+    aiConfig.budgetUs = 20;
+
+    std::vector<std::unique_ptr<Player>> players;
+    for (int m = 0; m < cfg.matches; ++m) {
+        for (int side = 0; side < 2; ++side) {
+            std::unique_ptr<Player> p(new Player());
+            p->ai = EnemyAI((Owner)side, aiConfig);
+            if (!p->client.connect(cfg.host, port, (uint32_t)m + 1, side, error)) {
+                std::fprintf(stderr, "%s\n", error.c_str());
+                return 1;
+            }
+            players.push_back(std::move(p));
+        }
+    }
+
+    std::vector<std::unique_ptr<Watcher>> watchers;
+    for (int m = 0; m < cfg.matches; ++m) {
+        for (int k = 0; k < cfg.watchers; ++k) {
+            std::unique_ptr<Watcher> w(new Watcher());
+            if (!w->client.connect(cfg.host, port, (uint32_t)m + 1, error)) {
+                std::fprintf(stderr, "%s\n", error.c_str());
+                return 1;
+            }
+            watchers.push_back(std::move(w));
+        }
+    }
+
+    std::vector<pollfd> fds(players.size() + watchers.size());
+    auto start = std::chrono::steady_clock::now();
+    int failures = 0;
+
+    while (std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() < cfg.seconds) {
+        for (size_t i = 0; i < players.size(); ++i) {
+            fds[i].fd = players[i]->failed ? -1 : players[i]->client.fd();
+            fds[i].events = POLLIN;
+            fds[i].revents = 0;
+        }
+        for (size_t i = 0; i < watchers.size(); ++i) {
+            pollfd& pfd = fds[players.size() + i];
+            pfd.fd = watchers[i]->failed ? -1 : watchers[i]->client.fd();
+            pfd.events = POLLIN;
+            pfd.revents = 0;
+        }
+        if (::poll(fds.data(), fds.size(), 10) < 0) break;
+
+        for (size_t i = 0; i < watchers.size(); ++i) {
+            Watcher& w = *watchers[i];
+            if (w.failed || !(fds[players.size() + i].revents & (POLLIN | POLLHUP | POLLERR))) continue;
+            if (!w.client.poll(error)) {
+                std::fprintf(stderr, "watcher %zu: %s\n", i, error.c_str());
+                w.failed = true;
+                failures++;
+            }
+        }
+
+        for (size_t i = 0; i < players.size(); ++i) {
+            Player& p = *players[i];
+            if (p.failed || !(fds[i].revents & (POLLIN | POLLHUP | POLLERR))) continue;
+
+            int before = p.game.tick;
+            if (!p.client.poll(error)) {
+                std::fprintf(stderr, "client %zu: %s\n", i, error.c_str());
+                p.failed = true;
+                failures++;
+                continue;
+            }
+
+            // think once per new state; its roads go out on the next poll
+            if (p.game.tick != before && !p.game.gameOver) p.ai.update(p.game);
+        }
+    }
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    long long batches = 0, checks = 0, desyncs = 0;
+    int over = 0;
+    for (const auto& p : players) {
+        batches += p->client.batches;
+        checks += p->client.hashChecks;
+        desyncs += p->client.desyncs;
+        if (p->game.gameOver) over++;
+    }
+    players.clear();
+
+    long long watchBytes = 0, keyframes = 0, deltas = 0, mismatches = 0, rejects = 0;
+    for (const auto& w : watchers) {
+        watchBytes += w->client.bytes;
+        keyframes += w->client.stream().keyframes;
+        deltas += w->client.stream().deltas;
+        mismatches += w->client.stream().mismatches;
+        rejects += w->client.errors;
+    }
+
+    std::printf("%d matches, %d clients for %.1f s: %lld batches (%.0f/s), %d clients saw their match end\n",
+                cfg.matches, 2 * cfg.matches, elapsed, batches, batches / elapsed, over);
+    std::printf("%lld hash checks, %lld desyncs, %d client errors\n", checks, desyncs, failures);
+    if (!watchers.empty()) {
+        std::printf("%zu watchers: %lld keyframes, %lld deltas, %.0f bytes/s each, "
+                    "%lld rejected deltas, %lld keyframe mismatches\n",
+                    watchers.size(), keyframes, deltas, watchBytes / elapsed / watchers.size(),
+                    rejects, mismatches);
+    }
+    watchers.clear();
+
+    if (server) {
+        server->stop();
+        serverThread.join();
+
+        const ServerStats& s = server->stats();
+        std::printf("server: %lld matches started, %lld finished, %lld ticks, %lld commands, "
+                    "%lld rejected, %lld overflows, %.1f us per match tick\n",
+                    s.matchesStarted, s.matchesFinished, s.ticks, s.commands, s.rejected, s.overflows,
+                    s.ticks ? s.stepSeconds * 1e6 / s.ticks : 0.0);
+    }
+    return desyncs == 0 && failures == 0 && rejects == 0 && mismatches == 0 ? 0 : 1;
+}
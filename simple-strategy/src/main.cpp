@@ -1,13 +1,25 @@
 #include <graphics.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include "Client.h"
 #include "GlobalState.h"
-
-GlobalState game;
+#include "Frontend.h"
+#include "Replay.h"
+#include "Ruleset.h"
 
 static const int W = 1200;
 static const int H = 700;
 
+GlobalState game;
+Frontend frontend(game, (float)W, (float)H);
+LockstepClient client(game);
+SpectatorClient watcher(game);
+
 void update(float dt) {
-    game.update(dt);
+    frontend.update(dt);
 }
 
 void draw() {
@@ -15,18 +27,123 @@ void draw() {
     br.fill_color[0] = br.fill_color[1] = br.fill_color[2] = 0.1f;
     graphics::drawRect(W * 0.5f, H * 0.5f, (float)W, (float)H, br);
 
-    game.draw();
+    frontend.draw(game.clock.alpha());
 }
 
-int main() {
+// host:port[:match]
+static void parseAddress(std::string arg, std::string& host, uint16_t& port, uint32_t& matchId)
+{
+    size_t colon = arg.find(':');
+    if (colon != std::string::npos) {
+        std::string rest = arg.substr(colon + 1);
+        arg.resize(colon);
+        port = (uint16_t)std::atoi(rest.c_str());
+        size_t second = rest.find(':');
+        if (second != std::string::npos)
+            matchId = (uint32_t)std::strtoul(rest.c_str() + second + 1, nullptr, 10);
+    }
+    host = arg;
+}
+
+int main(int argc, char** argv) {
+    std::string mapPath, recordPath, connectTo, watchAddress;
+    bool streams = false;
+    GameMode mode = GameMode::Standard;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--record" && i + 1 < argc) recordPath = argv[++i];
+        else if (arg == "--connect" && i + 1 < argc) connectTo = argv[++i];
+        else if (arg == "--watch" && i + 1 < argc) watchAddress = argv[++i];
+        else if (arg == "--no-ai") frontend.setAIEnabled(false);
+        else if (arg == "--streams") streams = true;
+        else if (arg == "--mode" && i + 1 < argc) {
+            if (!parseGameMode(argv[++i], mode)) {
+                std::fprintf(stderr, "unknown mode %s (standard, blitz, siege)\n", argv[i]);
+                return 1;
+            }
+        }
+        else mapPath = arg;
+    }
+
+    // --connect host:port[:match] plays a strategy_server match, --watch
+    // follows one; either way the server sends the map
+    if (!watchAddress.empty() && !recordPath.empty()) {
+        std::fprintf(stderr, "--record cannot record a watched match\n");
+        return 1;
+    }
+    if (!connectTo.empty() || !watchAddress.empty()) {
+        std::string host;
+        uint16_t port = 7777;
+        uint32_t matchId = 1;
+        bool watching = connectTo.empty();
+        parseAddress(watching ? watchAddress : connectTo, host, port, matchId);
+
+        std::string error;
+        bool ok = watching ? watcher.connect(host, port, matchId, error)
+                           : client.connect(host, port, matchId, 2, error);
+        if (!ok) {
+            std::fprintf(stderr, "%s\n", error.c_str());
+            return 1;
+        }
+        // wait for the first state so the camera can frame the server's map
+        while (watching ? !watcher.ready() : !client.joined()) {
+            if (watching ? !watcher.poll(error) : !client.poll(error)) {
+                std::fprintf(stderr, "%s\n", error.c_str());
+                return 1;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        if (watching) frontend.setWatcher(&watcher);
+        else frontend.setClient(&client);
+    }
+
+    // optional map file, text or binary, or a saved game; the built-in
+    // layout otherwise
+    if (!connectTo.empty() || !watchAddress.empty()) {
+        // already loaded
+    } else if (!mapPath.empty()) {
+        std::string error;
+        bool saved = isSnapshot(mapPath);
+        if (saved && !recordPath.empty()) {
+            std::fprintf(stderr, "--record needs a map, not a saved game\n");
+            return 1;
+        }
+        if (saved ? !game.restoreFile(mapPath, error) : !game.loadFile(mapPath, error)) {
+            std::fprintf(stderr, "%s\n", error.c_str());
+            return 1;
+        }
+    } else {
+        game.init();
+    }
+    // a saved or server game keeps its own rules
+    if (connectTo.empty() && watchAddress.empty() && !isSnapshot(mapPath)) {
+        game.rules = rulesFor(mode);
+        if (streams) game.rules.unitStreams = true;
+    }
+    frontend.resetCamera();
+
+    // with --record, every effective command is logged for strategy_replay
+    ReplayLog replay;
+    if (!recordPath.empty()) {
+        replay.begin(game);
+        game.recorder = &replay;
+    }
+
     graphics::createWindow(W, H, "Strategy Nodes");
     graphics::setFont("assets/DejaVuSans.ttf");
 
-    game.init();
-
     graphics::setDrawFunction(draw);
     graphics::setUpdateFunction(update);
     graphics::startMessageLoop();
 
+    if (!recordPath.empty()) {
+        std::string error;
+        replay.finish(game);
+        if (!replay.save(recordPath, error))
+            std::fprintf(stderr, "%s\n", error.c_str());
+    }
+
+    frontend.shutdown();
+    graphics::destroyWindow();
     return 0;
 }
@@ -0,0 +1,106 @@
+// Replay player: re-simulates a recorded match headlessly at full speed and
+// prints where it ended up. The state hash lets two runs be compared.
+#include "Map.h"
+#include "Replay.h"
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+static void usage()
+{
+    std::fprintf(stderr,
+        "usage: strategy_replay <replay> [options]\n"
+        "  --map PATH        map the match was recorded on (default: built-in)\n"
+        "  --to T            stop at tick T (default: where the recording stopped)\n"
+        "  --seek T          after running, seek back or forward to tick T\n"
+        "  --snapshot N      ticks between seek snapshots (default 1800)\n");
+}
+
+static void report(const char* label, const GlobalState& game)
+{
+    const char* result = !game.gameOver ? "running"
+        : game.winner == Owner::Player ? "player won" : "enemy won";
+    std::printf("%-8s tick %d  %s  hash %016" PRIx64 "\n",
+        label, game.tick, result, game.stateHash());
+}
+
+int main(int argc, char** argv)
+{
+    std::string replayPath, mapPath;
+    int to = -1, seekTo = -1, snapshot = TICK_RATE * 60;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if (arg == "--map" && hasValue)            mapPath = argv[++i];
+        else if (arg == "--to" && hasValue)        to = std::atoi(argv[++i]);
+        else if (arg == "--seek" && hasValue)      seekTo = std::atoi(argv[++i]);
+        else if (arg == "--snapshot" && hasValue)  snapshot = std::atoi(argv[++i]);
+        else if (replayPath.empty() && arg[0] != '-') replayPath = arg;
+        else {
+            usage();
+            return 1;
+        }
+    }
+    if (replayPath.empty()) {
+        usage();
+        return 1;
+    }
+
+    std::string error;
+    ReplayLog log;
+    if (!log.load(replayPath, error)) {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+
+    MapData builtin;
+    MapFile file;
+    MapData text;
+    MapView map;
+    if (mapPath.empty()) {
+        builtin = defaultMap();
+        map = builtin.view();
+    } else if (isBinaryMap(mapPath)) {
+        if (!file.open(mapPath, error)) {
+            std::fprintf(stderr, "%s\n", error.c_str());
+            return 1;
+        }
+        map = file.view();
+    } else {
+        if (!loadMapText(mapPath, text, error)) {
+            std::fprintf(stderr, "%s\n", error.c_str());
+            return 1;
+        }
+        map = text.view();
+    }
+
+    ReplayPlayer player(map, log, snapshot);
+    if (!log.fits(player.state())) {
+        std::fprintf(stderr, "%s: recorded on a different map\n", replayPath.c_str());
+        return 1;
+    }
+
+    std::printf("%zu commands, last on tick %d, recorded to tick %d\n",
+                log.commands.size(), player.lastCommandTick(), log.endTick);
+
+    auto t0 = std::chrono::steady_clock::now();
+    player.runTo(to >= 0 ? to : log.endTick);
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    report("end", player.state());
+    std::printf("%.0f ticks/s\n", secs > 0 ? player.state().tick / secs : 0.0);
+
+    if (seekTo >= 0) {
+        t0 = std::chrono::steady_clock::now();
+        player.seek(seekTo);
+        secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+        report("seek", player.state());
+        std::printf("seek took %.2f ms\n", secs * 1000.0);
+    }
+    return 0;
+}
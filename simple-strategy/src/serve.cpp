@@ -0,0 +1,65 @@
+// Headless lockstep server: hosts matches for strategy_nodes --connect and
+// strategy_loadtest clients until interrupted.
+#include "Server.h"
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+static LockstepServer* running = nullptr;
+
+static void onSignal(int)
+{
+    if (running) running->stop();
+}
+
+static void usage()
+{
+    std::fprintf(stderr,
+        "usage: strategy_server [options]\n"
+        "  --port N          TCP port (default 7777)\n"
+        "  --layers N        layers per side of every match's map (default 4)\n"
+        "  --width N         nodes per layer (default 4)\n"
+        "  --seed N          map seed (default 1)\n"
+        "  --delay N         input delay in ticks (default 3)\n");
+}
+
+int main(int argc, char** argv)
+{
+    ServerConfig cfg;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if (arg == "--port" && hasValue)         cfg.port = (uint16_t)std::atoi(argv[++i]);
+        else if (arg == "--layers" && hasValue)  cfg.layers = std::atoi(argv[++i]);
+        else if (arg == "--width" && hasValue)   cfg.width = std::atoi(argv[++i]);
+        else if (arg == "--seed" && hasValue)    cfg.seed = (uint32_t)std::strtoul(argv[++i], nullptr, 10);
+        else if (arg == "--delay" && hasValue)   cfg.inputDelay = std::atoi(argv[++i]);
+        else {
+            usage();
+            return arg == "--help" ? 0 : 1;
+        }
+    }
+
+    LockstepServer server(cfg);
+    std::string error;
+    if (!server.start(error)) {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+
+    running = &server;
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
+
+    std::printf("listening on port %u\n", (unsigned)server.port());
+    std::fflush(stdout);
+    server.run();
+
+    const ServerStats& s = server.stats();
+    std::printf("%lld connections, %lld matches started, %lld finished, %lld ticks, %lld commands\n",
+                s.connections, s.matchesStarted, s.matchesFinished, s.ticks, s.commands);
+    return 0;
+}
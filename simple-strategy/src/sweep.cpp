@@ -0,0 +1,173 @@
+// Parameter sweep: plays every combination of the given rule values on a
+// set of generated maps, spreading the matches over all cores, and prints
+// one summary row per combination.
+#include "Match.h"
+#include "WorkStealingPool.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+struct SweepConfig {
+    int maps = 16;
+    int layers = 6;
+    int width = 8;
+    int maxTicks = 30 * 60 * 5;
+    int threads = 0;
+    uint32_t seed = 1;
+    std::vector<float> sendIntervals = { 0.5f, 1.0f, 2.0f };
+    std::vector<float> produceIntervals = { 1.5f, 3.0f, 6.0f };
+    std::vector<float> margins = { 2.0f };
+    std::string format = "table";
+};
+
+struct SweepRow {
+    Rules rules;
+    int matches = 0;
+    int playerWins = 0;
+    int enemyWins = 0;
+    int timeouts = 0;
+    long long ticks = 0;
+    long long playerNodes = 0;
+    long long totalNodes = 0;
+};
+
+static bool parseList(const char* text, std::vector<float>& out)
+{
+    out.clear();
+    for (const char* p = text; *p;) {
+        char* end;
+        float v = std::strtof(p, &end);
+        if (end == p) return false;
+        out.push_back(v);
+        p = *end == ',' ? end + 1 : end;
+    }
+    return !out.empty();
+}
+
+static void usage()
+{
+    std::fprintf(stderr,
+        "usage: strategy_sweep [options]\n"
+        "  --maps N          generated maps per combination (default 16)\n"
+        "  --layers N        layers per side (default 6)\n"
+        "  --width N         nodes per layer (default 8)\n"
+        "  --ticks N         tick limit per match (default 9000)\n"
+        "  --threads N       worker threads, 0 for all cores (default 0)\n"
+        "  --seed N          seed of the first map (default 1)\n"
+        "  --send a,b,...    send intervals to try, seconds\n"
+        "  --produce a,b,... production intervals to try, seconds\n"
+        "  --margin a,b,...  lateral redistribution margins to try\n"
+        "  --format F        table or csv\n");
+}
+
+int main(int argc, char** argv)
+{
+    SweepConfig cfg;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        bool ok = true;
+
+        if (arg == "--maps" && hasValue)          cfg.maps = std::atoi(argv[++i]);
+        else if (arg == "--layers" && hasValue)   cfg.layers = std::atoi(argv[++i]);
+        else if (arg == "--width" && hasValue)    cfg.width = std::atoi(argv[++i]);
+        else if (arg == "--ticks" && hasValue)    cfg.maxTicks = std::atoi(argv[++i]);
+        else if (arg == "--threads" && hasValue)  cfg.threads = std::atoi(argv[++i]);
+        else if (arg == "--seed" && hasValue)     cfg.seed = (uint32_t)std::strtoul(argv[++i], nullptr, 10);
+        else if (arg == "--send" && hasValue)     ok = parseList(argv[++i], cfg.sendIntervals);
+        else if (arg == "--produce" && hasValue)  ok = parseList(argv[++i], cfg.produceIntervals);
+        else if (arg == "--margin" && hasValue)   ok = parseList(argv[++i], cfg.margins);
+        else if (arg == "--format" && hasValue)   cfg.format = argv[++i];
+        else ok = false;
+
+        if (!ok) {
+            usage();
+            return arg == "--help" ? 0 : 1;
+        }
+    }
+
+    if (cfg.maps <= 0 || (cfg.format != "table" && cfg.format != "csv")) {
+        usage();
+        return 1;
+    }
+
+    // maps are generated once and shared read-only by all matches
+    std::vector<MapData> maps;
+    for (int m = 0; m < cfg.maps; ++m)
+        maps.push_back(generateMap(cfg.layers, cfg.width, cfg.seed + (uint32_t)m));
+
+    std::vector<SweepRow> rows;
+    for (float send : cfg.sendIntervals)
+        for (float produce : cfg.produceIntervals)
+            for (float margin : cfg.margins) {
+                SweepRow row;
+                row.rules.sendInterval = send;
+                row.rules.produceInterval = produce;
+                row.rules.redistributeMargin = (int)margin;
+                if (!row.rules.valid()) {
+                    std::fprintf(stderr, "send %g, produce %g: intervals must be positive and finite\n",
+                                 send, produce);
+                    return 1;
+                }
+                rows.push_back(row);
+            }
+
+    size_t jobs = rows.size() * maps.size();
+    std::vector<MatchResult> results(jobs);
+
+    WorkStealingPool pool(cfg.threads);
+    auto start = std::chrono::steady_clock::now();
+
+    pool.run(jobs, [&](size_t i, int) {
+        const SweepRow& row = rows[i / maps.size()];
+        results[i] = runMatch(maps[i % maps.size()].view(), row.rules, cfg.maxTicks);
+    });
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    for (size_t i = 0; i < jobs; ++i) {
+        SweepRow& row = rows[i / maps.size()];
+        const MatchResult& r = results[i];
+
+        row.matches++;
+        row.ticks += r.ticks;
+        row.playerNodes += r.nodes[(int)Owner::Player];
+        row.totalNodes += r.nodes[0] + r.nodes[1];
+
+        if (!r.finished)                    row.timeouts++;
+        else if (r.winner == Owner::Player) row.playerWins++;
+        else                                row.enemyWins++;
+    }
+
+    if (cfg.format == "csv") {
+        std::printf("send,produce,margin,matches,player_wins,enemy_wins,timeouts,avg_ticks,player_node_share\n");
+    } else {
+        std::printf("%6s %8s %6s %8s %7s %7s %8s %10s %12s\n",
+                    "send", "produce", "margin", "matches", "blue", "red", "timeout",
+                    "avg ticks", "blue nodes %");
+    }
+
+    for (const SweepRow& row : rows) {
+        double avgTicks = (double)row.ticks / row.matches;
+        double share = row.totalNodes ? 100.0 * row.playerNodes / row.totalNodes : 0.0;
+
+        if (cfg.format == "csv") {
+            std::printf("%g,%g,%d,%d,%d,%d,%d,%.1f,%.2f\n",
+                        row.rules.sendInterval, row.rules.produceInterval,
+                        row.rules.redistributeMargin, row.matches, row.playerWins,
+                        row.enemyWins, row.timeouts, avgTicks, share);
+        } else {
+            std::printf("%6g %8g %6d %8d %7d %7d %8d %10.1f %12.2f\n",
+                        row.rules.sendInterval, row.rules.produceInterval,
+                        row.rules.redistributeMargin, row.matches, row.playerWins,
+                        row.enemyWins, row.timeouts, avgTicks, share);
+        }
+    }
+
+    std::fprintf(stderr, "%zu matches on %d threads in %.2f s (%.1f matches/s)\n",
+                 jobs, pool.threadCount(), seconds, jobs / seconds);
+    return 0;
+}
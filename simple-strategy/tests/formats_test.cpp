@@ -0,0 +1,269 @@
+// Round trips and rejection tests for the replay, snapshot and network
+// frame formats. Exits non-zero if any check fails.
+#include "EnemyAI.h"
+#include "GlobalState.h"
+#include "Net.h"
+#include "Replay.h"
+#include "Snapshot.h"
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+static int failures = 0;
+
+#define CHECK(cond)                                                         \
+    do {                                                                    \
+        if (!(cond)) {                                                      \
+            std::fprintf(stderr, "%s:%d: failed: %s\n", __FILE__, __LINE__, \
+                         #cond);                                            \
+            failures++;                                                     \
+        }                                                                   \
+    } while (0)
+
+// Twenty seconds of two AIs on a small generated map, recorded. The
+// match is still running then, with units on the roads.
+static void playMatch(GlobalState& game, ReplayLog& log, const MapData& map, bool streams)
+{
+    game.rules.unitStreams = streams;
+    game.load(map.view());
+    log.begin(game);
+    game.recorder = &log;
+
+    AIConfig config;
+    config.budgetUs = 0;
+    EnemyAI ai[2] = { EnemyAI(Owner::Player, config), EnemyAI(Owner::Enemy, config) };
+
+    game.submit({ CommandType::Start });
+    for (int i = 0; i < TICK_RATE * 20 && !game.gameOver; ++i) {
+        for (EnemyAI& a : ai) a.update(game);
+        game.step();
+    }
+    game.recorder = nullptr;
+    log.finish(game);
+}
+
+static void testReplayRoundTrip(const MapData& map, bool streams)
+{
+    GlobalState game;
+    ReplayLog log;
+    playMatch(game, log, map, streams);
+    CHECK(log.commands.size() > 1 && !game.gameOver);
+
+    std::vector<uint8_t> bytes;
+    log.encode(bytes);
+
+    ReplayLog decoded;
+    std::string error;
+    CHECK(decoded.decode(bytes.data(), bytes.size(), error));
+    CHECK(decoded.endTick == game.tick);
+    CHECK(decoded.commands.size() == log.commands.size());
+    CHECK(decoded.rules.unitStreams == streams);
+
+    ReplayPlayer player(map.view(), decoded, TICK_RATE * 5);
+    CHECK(decoded.fits(player.state()));
+    player.runTo(decoded.endTick);
+    CHECK(player.state().tick == game.tick);
+    CHECK(player.state().stateHash() == game.stateHash());
+
+    // seeking back restores a snapshot the player took on the way
+    player.seek(decoded.endTick / 2);
+    player.runTo(decoded.endTick);
+    CHECK(player.state().stateHash() == game.stateHash());
+}
+
+static void testSnapshotRoundTrip(const MapData& map, bool streams)
+{
+    GlobalState game;
+    ReplayLog log;
+    playMatch(game, log, map, streams);
+
+    std::vector<uint8_t> bytes;
+    game.snapshot(bytes);
+
+    SnapshotView view;
+    std::string error;
+    CHECK(parseSnapshot(bytes.data(), bytes.size(), view, error));
+
+    GlobalState copy;
+    copy.restore(view);
+    CHECK(copy.tick == game.tick);
+    CHECK(copy.stateHash() == game.stateHash());
+
+    // and both play on identically
+    for (int i = 0; i < 300; ++i) {
+        game.step();
+        copy.step();
+    }
+    CHECK(copy.stateHash() == game.stateHash());
+}
+
+static uint32_t nextRandom(uint32_t& state)
+{
+    state = state * 1664525u + 1013904223u;
+    return state >> 8;
+}
+
+static void testReplayRejects(const MapData& map)
+{
+    GlobalState game;
+    ReplayLog log;
+    playMatch(game, log, map, false);
+
+    std::vector<uint8_t> bytes;
+    log.encode(bytes);
+    ReplayLog decoded;
+    std::string error;
+
+    // every proper prefix is missing something
+    for (size_t n = 0; n < bytes.size(); ++n) {
+        error.clear();
+        CHECK(!decoded.decode(bytes.data(), n, error) && !error.empty());
+    }
+
+    std::vector<uint8_t> bad = bytes;
+    bad[0] = 'X';
+    CHECK(!decoded.decode(bad.data(), bad.size(), error));
+
+    bad = bytes;
+    bad[4] = 99; // version
+    CHECK(!decoded.decode(bad.data(), bad.size(), error));
+
+    // unitSpeed, the third float after magic and version
+    bad = bytes;
+    std::memset(&bad[4 + 1 + 8], 0, 4);
+    CHECK(!decoded.decode(bad.data(), bad.size(), error));
+
+    float nan = std::nanf("");
+    uint32_t bits;
+    std::memcpy(&bits, &nan, 4);
+    bad = bytes;
+    for (int i = 0; i < 4; ++i) bad[4 + 1 + i] = (uint8_t)(bits >> (8 * i));
+    CHECK(!decoded.decode(bad.data(), bad.size(), error));
+
+    // a Connect to a node the map does not have
+    ReplayLog wrong = log;
+    wrong.record(log.endTick, { CommandType::Connect, 0, (int)log.nodeCount });
+    wrong.encode(bad);
+    CHECK(!decoded.decode(bad.data(), bad.size(), error));
+
+    // random damage: decoding may succeed, but must not read past the end
+    uint32_t seed = 7;
+    for (int i = 0; i < 2000; ++i) {
+        bad = bytes;
+        for (int k = 0; k < 3; ++k)
+            bad[nextRandom(seed) % bad.size()] = (uint8_t)nextRandom(seed);
+        decoded.decode(bad.data(), bad.size(), error);
+    }
+}
+
+static void testSnapshotRejects(const MapData& map)
+{
+    GlobalState game;
+    ReplayLog log;
+    playMatch(game, log, map, true);
+
+    std::vector<uint8_t> bytes;
+    game.snapshot(bytes);
+    SnapshotView view;
+    std::string error;
+
+    for (size_t n = 0; n < bytes.size(); ++n) {
+        error.clear();
+        CHECK(!parseSnapshot(bytes.data(), n, view, error) && !error.empty());
+    }
+
+    auto header = [](std::vector<uint8_t>& b) { return (SnapshotHeader*)b.data(); };
+    auto firstNode = [](std::vector<uint8_t>& b) { return (SnapshotNode*)(b.data() + sizeof(SnapshotHeader)); };
+
+    std::vector<uint8_t> bad = bytes;
+    header(bad)->version++;
+    CHECK(!parseSnapshot(bad.data(), bad.size(), view, error));
+
+    bad = bytes;
+    header(bad)->nodeCount++;
+    CHECK(!parseSnapshot(bad.data(), bad.size(), view, error));
+
+    bad = bytes;
+    header(bad)->enemyBase = header(bad)->playerBase;
+    CHECK(!parseSnapshot(bad.data(), bad.size(), view, error));
+
+    bad = bytes;
+    header(bad)->produceInterval = 0.0f;
+    CHECK(!parseSnapshot(bad.data(), bad.size(), view, error));
+
+    bad = bytes;
+    header(bad)->unitSpeed = std::nanf("");
+    CHECK(!parseSnapshot(bad.data(), bad.size(), view, error));
+
+    bad = bytes;
+    firstNode(bad)->x = INFINITY;
+    CHECK(!parseSnapshot(bad.data(), bad.size(), view, error));
+
+    bad = bytes;
+    firstNode(bad)->unitCount = firstNode(bad)->capacity + 1;
+    CHECK(!parseSnapshot(bad.data(), bad.size(), view, error));
+
+    bad = bytes;
+    firstNode(bad)->owner = 5;
+    CHECK(!parseSnapshot(bad.data(), bad.size(), view, error));
+}
+
+static void testFrames()
+{
+    std::vector<uint8_t> buf;
+    size_t start = beginFrame(buf, MsgType::Command);
+    buf.push_back(1);
+    buf.push_back(2);
+    finishFrame(buf, start);
+
+    size_t offset = 0;
+    MsgType type;
+    const uint8_t* payload;
+    size_t size;
+    std::string error;
+
+    // a partial frame waits for more bytes without an error
+    for (size_t n = 0; n < buf.size(); ++n) {
+        std::vector<uint8_t> part(buf.begin(), buf.begin() + n);
+        offset = 0;
+        error.clear();
+        CHECK(!nextFrame(part, offset, type, payload, size, error) && error.empty() && offset == 0);
+    }
+
+    offset = 0;
+    CHECK(nextFrame(buf, offset, type, payload, size, error));
+    CHECK(type == MsgType::Command && size == 2 && payload[0] == 1 && payload[1] == 2);
+    CHECK(offset == buf.size());
+
+    std::vector<uint8_t> empty = { 0, 0, 0, 0, (uint8_t)MsgType::Hello };
+    offset = 0;
+    error.clear();
+    CHECK(!nextFrame(empty, offset, type, payload, size, error) && !error.empty());
+
+    std::vector<uint8_t> huge = { 0xff, 0xff, 0xff, 0xff, (uint8_t)MsgType::Hello };
+    offset = 0;
+    error.clear();
+    CHECK(!nextFrame(huge, offset, type, payload, size, error) && !error.empty());
+}
+
+int main()
+{
+    MapData map = generateMap(5, 8, 11);
+
+    testReplayRoundTrip(map, false);
+    testReplayRoundTrip(map, true);
+    testSnapshotRoundTrip(map, false);
+    testSnapshotRoundTrip(map, true);
+    testReplayRejects(map);
+    testSnapshotRejects(map);
+    testFrames();
+
+    if (failures) {
+        std::fprintf(stderr, "%d checks failed\n", failures);
+        return 1;
+    }
+    std::printf("all checks passed\n");
+    return 0;
+}